@@ -0,0 +1,144 @@
+#ifndef _ARENA_ALLOCATOR_H_
+#define _ARENA_ALLOCATOR_H_
+// 作用域arena 适合建好一个链表或树 用完之后整体丢掉的场景
+// scoped_arena构造时成为本线程的当前arena 析构时恢复上一个 可以嵌套
+// arena_allocator可以作为list m_vector AVL_Tree的分配器模板参数
+// 和my_malloc_allocator一样提供allocate_batch/deallocate_batch
+// 它的deallocate什么也不做 所有内存在reset()或者scoped_arena析构时一起释放
+// 容器通过is_bulk_free_allocator识别它 元素可以平凡析构时跳过逐个节点的销毁
+// 例如
+//   scoped_arena arena;
+//   m_stl::list<int, arena_allocator> l;
+//   ...
+//   arena.reset();
+// 容器的生命周期不能超过它所用的scoped_arena
+// 没有scoped_arena时用arena_allocator申请内存会抛出std::logic_error
+//
+// 这个头文件不依赖memoryPool.h 只用arena的程序不需要链接memory_pool
+
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <new>
+#include <stdexcept>
+#include <type_traits>
+
+class scoped_arena {
+public:
+  enum { BLOCK_BYTES = 64 * 1024 };
+  enum { ALIGN = alignof(std::max_align_t) };
+
+  scoped_arena() : prev(current) { current = this; }
+  scoped_arena(const scoped_arena &) = delete;
+  scoped_arena &operator=(const scoped_arena &) = delete;
+
+  ~scoped_arena() {
+    release();
+    current = prev;
+  }
+
+  void *allocate(size_t n) {
+    n = (n + ALIGN - 1) & ~size_t(ALIGN - 1);
+    if (size_t(end_free - start_free) < n)
+      new_block(n);
+    char *result = start_free;
+    start_free += n;
+    return result;
+  }
+
+  // 释放全部内存 第一块留下来给之后的分配复用
+  void reset() {
+    if (blocks == nullptr)
+      return;
+    while (blocks->next != nullptr) {
+      block *next = blocks->next;
+      ::operator delete(blocks);
+      blocks = next;
+    }
+    start_free = reinterpret_cast<char *>(blocks) + HEADER_BYTES;
+    end_free = reinterpret_cast<char *>(blocks) + blocks->bytes;
+  }
+
+  // 释放全部内存 包括第一块
+  void release() {
+    while (blocks != nullptr) {
+      block *next = blocks->next;
+      ::operator delete(blocks);
+      blocks = next;
+    }
+    start_free = end_free = nullptr;
+  }
+
+  // 本线程的当前arena 必须有一个scoped_arena在作用域里
+  // 没有时不能退回到一个永远不释放的默认arena deallocate是空操作
+  // 生命周期很长的容器会一直占着内存 所以直接报错
+  static scoped_arena &get() {
+    assert(current != nullptr && "arena_allocator needs an active scoped_arena");
+    if (current == nullptr)
+      throw std::logic_error("arena_allocator used without a scoped_arena");
+    return *current;
+  }
+
+private:
+  struct block {
+    block *next;
+    size_t bytes;
+  };
+  enum { HEADER_BYTES = (sizeof(block) + ALIGN - 1) & ~(ALIGN - 1) };
+
+  // 新块放在链表头 reset时只保留最早的那一块
+  void new_block(size_t n) {
+    size_t bytes = n + HEADER_BYTES;
+    if (bytes < BLOCK_BYTES)
+      bytes = BLOCK_BYTES;
+    block *b = static_cast<block *>(::operator new(bytes));
+    b->bytes = bytes;
+    if (blocks == nullptr) {
+      b->next = nullptr;
+      blocks = b;
+    } else {
+      b->next = blocks->next;
+      blocks->next = b;
+    }
+    start_free = reinterpret_cast<char *>(b) + HEADER_BYTES;
+    end_free = reinterpret_cast<char *>(b) + bytes;
+  }
+
+  inline static thread_local scoped_arena *current = nullptr;
+
+  scoped_arena *prev;
+  block *blocks = nullptr;
+  char *start_free = nullptr;
+  char *end_free = nullptr;
+};
+
+// 和my_malloc_allocator一样全是静态函数 容器里默认构造的成员也可以直接用
+struct arena_allocator {
+  // 标记deallocate是空操作 内存整体释放
+  using bulk_free = std::true_type;
+
+  static void initializer() {}
+  static void *allocate(size_t n) { return scoped_arena::get().allocate(n); }
+  static void deallocate(void *, size_t) {}
+  static void allocate_batch(size_t n, size_t count, void **out) {
+    scoped_arena &arena = scoped_arena::get();
+    for (size_t i = 0; i < count; i++)
+      out[i] = arena.allocate(n);
+  }
+  static void deallocate_batch(size_t, size_t, void *const *) {}
+};
+
+// 分配器带有bulk_free标记时为true
+template <typename Alloc, typename = void>
+struct is_bulk_free_allocator : std::false_type {};
+
+template <typename Alloc>
+struct is_bulk_free_allocator<Alloc, std::void_t<typename Alloc::bulk_free>>
+    : Alloc::bulk_free {};
+
+// 元素可以平凡析构并且分配器整体释放时 容器销毁时不需要逐个访问节点
+template <typename Alloc, typename T>
+inline constexpr bool skip_destroy_v =
+    is_bulk_free_allocator<Alloc>::value && std::is_trivially_destructible_v<T>;
+
+#endif // _ARENA_ALLOCATOR_H_
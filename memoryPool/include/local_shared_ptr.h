@@ -0,0 +1,95 @@
+#ifndef _LOCAL_SHARED_PTR_H_
+#define _LOCAL_SHARED_PTR_H_
+// 单线程使用的侵入式引用计数智能指针
+// 计数和对象放在同一次内存池申请里 计数用普通的size_t 不做原子操作
+// 只能在一个线程里拷贝和析构 跨线程共享请用make_shared_with_pool
+// 例如 auto p = make_local_shared_with_pool<std::string>("hello");
+
+#include "./memoryPool.h"
+#include <cstddef>
+#include <new>
+#include <utility>
+
+template <typename T> class local_shared_ptr {
+public:
+  using element_type = T;
+
+  local_shared_ptr() noexcept = default;
+  local_shared_ptr(std::nullptr_t) noexcept {}
+
+  local_shared_ptr(const local_shared_ptr &other) noexcept : ctrl(other.ctrl) {
+    if (ctrl)
+      ctrl->count++;
+  }
+  local_shared_ptr(local_shared_ptr &&other) noexcept : ctrl(other.ctrl) {
+    other.ctrl = nullptr;
+  }
+
+  local_shared_ptr &operator=(local_shared_ptr other) noexcept {
+    swap(other);
+    return *this;
+  }
+
+  ~local_shared_ptr() { release(); }
+
+  void reset() noexcept {
+    release();
+    ctrl = nullptr;
+  }
+  void swap(local_shared_ptr &other) noexcept { std::swap(ctrl, other.ctrl); }
+
+  T *get() const noexcept { return ctrl ? &ctrl->value : nullptr; }
+  T &operator*() const noexcept { return ctrl->value; }
+  T *operator->() const noexcept { return &ctrl->value; }
+  size_t use_count() const noexcept { return ctrl ? ctrl->count : 0; }
+  explicit operator bool() const noexcept { return ctrl != nullptr; }
+
+  template <typename U, typename... Args>
+  friend local_shared_ptr<U> make_local_shared_with_pool(Args &&...args);
+
+private:
+  struct control {
+    size_t count;
+    T value;
+
+    template <typename... Args>
+    explicit control(Args &&...args)
+        : count(1), value(std::forward<Args>(args)...) {}
+  };
+
+  void release() noexcept {
+    if (ctrl && --ctrl->count == 0) {
+      ctrl->~control();
+      my_malloc_allocator::deallocate(ctrl, sizeof(control),
+                                      alignof(control));
+    }
+  }
+
+  control *ctrl = nullptr;
+};
+
+template <typename T, typename... Args>
+local_shared_ptr<T> make_local_shared_with_pool(Args &&...args) {
+  using control = typename local_shared_ptr<T>::control;
+  void *p = my_malloc_allocator::allocate(sizeof(control), alignof(control));
+  local_shared_ptr<T> result;
+  try {
+    result.ctrl = ::new (p) control(std::forward<Args>(args)...);
+  } catch (...) {
+    my_malloc_allocator::deallocate(p, sizeof(control), alignof(control));
+    throw;
+  }
+  return result;
+}
+
+template <typename T, typename U>
+bool operator==(const local_shared_ptr<T> &a, const local_shared_ptr<U> &b) {
+  return a.get() == b.get();
+}
+
+template <typename T, typename U>
+bool operator!=(const local_shared_ptr<T> &a, const local_shared_ptr<U> &b) {
+  return a.get() != b.get();
+}
+
+#endif // _LOCAL_SHARED_PTR_H_
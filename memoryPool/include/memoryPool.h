@@ -3,7 +3,10 @@
 // 使用的是linux Ubuntu 24 发行版对应的页的大小是4096B
 // 首先获取不同系统下的页大小
 
+#include <atomic>
 #include <cstddef>
+#include <cstdint>
+#include <iosfwd>
 #include <memory>
 #include <new>
 
@@ -13,10 +16,17 @@
 #include <unistd.h>
 #endif // defined(_WIN32) || defined(_WIN64)
 
+// 线程模式在编译时三选一:
+// POOL_SINGLE_THREAD 单线程模式 不做任何同步
+// POOL_LOCK_FREE     无锁模式 每个大小类别的free_list是带版本号的无锁栈
+//                    只有从chunk切新内存的时候才加锁
+// 默认               互斥锁模式 所有free_list共用一把全局锁
+#if !defined(POOL_SINGLE_THREAD)
 #define THREAD_ON
-// THREADS_ON 多线程启动 和 包含 pthread.h的时候启动线程安全
+#endif // !defined(POOL_SINGLE_THREAD)
 
-#if defined(THREAD_ON) && defined(_PTHREAD_H)
+// 多线程模式直接包含pthread.h 不再依赖使用者的包含顺序
+#if defined(THREAD_ON)
 #include <pthread.h>
 #define LOCK(mtx) pthread_mutex_lock(mtx)
 #define UNLOCK(mtx) pthread_mutex_unlock(mtx)
@@ -26,6 +36,109 @@
 #define UNLOCK(mtx)
 #endif // defined(THREAD_ON)
 
+#if defined(THREAD_ON) && defined(POOL_LOCK_FREE)
+#define LOCK_FREE_ON true
+#else
+#define LOCK_FREE_ON false
+#endif // defined(THREAD_ON) && defined(POOL_LOCK_FREE)
+
+// LIST_LOCK 保护free_list CHUNK_LOCK 保护start_free/end_free/heap_size
+// 互斥锁模式下两者是同一把锁 拿到LIST_LOCK就不需要再拿CHUNK_LOCK
+// 无锁模式下free_list不需要加锁 只有切chunk的慢路径加锁
+#if LOCK_FREE_ON
+#define LIST_LOCK(mtx)
+#define LIST_UNLOCK(mtx)
+#define CHUNK_LOCK(mtx) LOCK(mtx)
+#define CHUNK_UNLOCK(mtx) UNLOCK(mtx)
+#else
+#define LIST_LOCK(mtx) LOCK(mtx)
+#define LIST_UNLOCK(mtx) UNLOCK(mtx)
+#define CHUNK_LOCK(mtx)
+#define CHUNK_UNLOCK(mtx)
+#endif // LOCK_FREE_ON
+
+// POOL_ARENA 打开后span不再单独mmap 而是从一次保留的大块虚拟内存里顺序切出
+// 保留的区域按2MB对齐 再定义POOL_HUGE_PAGE会对它请求透明大页(MADV_HUGEPAGE)
+// 树和链表的节点集中在少量大页里 遍历时TLB miss更少
+#if defined(POOL_ARENA) && !defined(_WIN32) && !defined(_WIN64)
+#define ARENA_ON true
+#else
+#define ARENA_ON false
+#endif // defined(POOL_ARENA)
+
+// POOL_NUMA 打开后每个NUMA节点有自己的一组free_list和chunk
+// 新的span用mbind绑定到所属节点 线程默认使用第一次分配时所在CPU的节点
+// 也可以用set_thread_node指定 节点个数的上限是POOL_NUMA_NODES 默认4
+#if defined(POOL_NUMA) && defined(__linux__)
+#define NUMA_ON true
+#if !defined(POOL_NUMA_NODES)
+#define POOL_NUMA_NODES 4
+#endif // !defined(POOL_NUMA_NODES)
+#else
+#define NUMA_ON false
+#endif // defined(POOL_NUMA) && defined(__linux__)
+
+// 分配统计 默认打开 定义 POOL_STATS_OFF 可以在编译时去掉所有计数
+// 计数都放在慢路径或者已经持有锁的地方 线程缓存的快路径上不做任何计数
+// 多线程模式下计数器是relaxed原子变量
+#if defined(POOL_STATS_OFF)
+#define STATS_ON false
+#define STAT_ADD(counter, n)
+#elif defined(THREAD_ON)
+#define STATS_ON true
+#define STAT_ADD(counter, n)                                                   \
+  ((counter).fetch_add((n), std::memory_order_relaxed))
+#else
+#define STATS_ON true
+#define STAT_ADD(counter, n) ((counter) += (n))
+#endif // defined(POOL_STATS_OFF)
+
+// 多线程模式下默认在全局free_list前面加一层线程本地缓存
+// 常见路径只访问本线程的缓存 不需要加锁 定义 THREAD_CACHE_OFF 可以关闭
+#if defined(THREAD_ON) && !defined(THREAD_CACHE_OFF)
+#define THREAD_CACHE_ON true
+#else
+#define THREAD_CACHE_ON false
+#endif // !defined(THREAD_CACHE_OFF)
+
+// POOL_DEBUG 打开调试模式 用来定位越界写 释放后使用和重复释放
+// 每次申请前后各加一段红区 释放时检查红区 并把对象填满DEBUG_FREED_BYTE
+// 对象头记录状态 重复释放或者释放的大小对不上时立即报错退出
+// 对象再次被申请时检查释放后的填充有没有被改写
+// 用AddressSanitizer编译时红区和已释放的对象会被标记成不可访问
+// 程序退出时按大小类别输出还没有释放的对象
+#if defined(POOL_DEBUG)
+#define DEBUG_ON true
+#else
+#define DEBUG_ON false
+#endif // defined(POOL_DEBUG)
+
+// POOL_PAGEMAP 打开后可以不传大小直接deallocate(p)
+// 每个大小类别从自己的span里切对象 一棵以span编号为键的基数树记录
+// 每个span属于哪个类别 不在基数树里的指针是大对象
+// 大对象前面多一个记录大小和对齐的头
+// 代价是用到的每个类别至少占一个span 内存不足时也不能从别的类别借内存
+// POOL_GLOBAL_NEW 表示程序用内存池替换了全局operator new/delete
+// (见src/pool_new_delete.cpp) 这时大对象改用malloc申请 避免递归回operator new
+// 不带大小的operator delete需要基数树 所以同时打开POOL_PAGEMAP
+#if defined(POOL_GLOBAL_NEW) && !defined(POOL_PAGEMAP)
+#define POOL_PAGEMAP
+#endif // defined(POOL_GLOBAL_NEW) && !defined(POOL_PAGEMAP)
+
+#if defined(POOL_PAGEMAP)
+#define PAGEMAP_ON true
+#else
+#define PAGEMAP_ON false
+#endif // defined(POOL_PAGEMAP)
+
+// linux下不小于BIG_MMAP_BYTES的大对象直接用mmap映射
+// 这样reallocate可以用mremap移动页表 不需要复制数据 其他系统上仍然走new
+#if defined(__linux__)
+#define BIG_MMAP_ON true
+#else
+#define BIG_MMAP_ON false
+#endif // defined(__linux__)
+
 inline size_t get_page_size() {
   static size_t page_size = 0;
   if (page_size != 0)
@@ -48,20 +161,66 @@ inline size_t get_page_size() {
 #define DOUBLE_ALLOC_ON true
 #endif // defined(DOUBLE_ALLOCATOR_OFF)
 
+// 二级分配器的大小类别表 参考jemalloc的划分方式
+// 8, 16~128按16递增, 之后每翻一倍分成4档一直到4096 一共29个类别
+// 相邻类别之间最多相差25% 比起按8字节递增的512条链表 绝大部分链表不会空着
+// index把(n + 7) / 8映射到能装下n字节的最小类别 查表不需要做除法
+// nobj是每次从chunk切出的个数 让一次切出的内存尽量接近一页
+// align是类别的自然对齐 即size最低的1位 最多MAX_ALIGN
+// 切分时每个对象都按自然对齐放 所以64的倍数的类别里的对象都是64字节对齐的
+struct size_class_table {
+  enum { ALIGN = 8 };
+  enum { MAX_ALIGN = 64 };
+  enum { MAX_BYTES = 4096 };
+  enum { CLASS_COUNT = 29 };
+  enum { REFILL_BYTES = 4096 };
+
+  unsigned short size[CLASS_COUNT];
+  unsigned short nobj[CLASS_COUNT];
+  unsigned char align[CLASS_COUNT];
+  unsigned char index[MAX_BYTES / ALIGN + 1];
+
+  constexpr size_class_table() : size(), nobj(), align(), index() {
+    int c = 0;
+    size[c++] = 8;
+    for (int s = 16; s <= 128; s += 16)
+      size[c++] = s;
+    for (int base = 128; base < MAX_BYTES; base *= 2)
+      for (int i = 1; i <= 4; i++)
+        size[c++] = base + i * (base / 4);
+
+    for (int i = 0; i < CLASS_COUNT; i++) {
+      int n = REFILL_BYTES / size[i];
+      nobj[i] = n < 2 ? 2 : n;
+      int a = size[i] & -size[i];
+      align[i] = a > MAX_ALIGN ? MAX_ALIGN : a;
+    }
+
+    int cls = 0;
+    for (int i = 0; i <= MAX_BYTES / ALIGN; i++) {
+      while (size[cls] < i * ALIGN)
+        cls++;
+      index[i] = cls;
+    }
+  }
+};
+
+inline constexpr size_class_table size_classes{};
+
 // 实现编译时多个内存池
 class my_malloc_allocator {
-
+public:
   using custom_alloc_false_func = void (*)(); // 内存分配失败处理函数别名
 
-public:
   // 首先初始化函数负责首次初始化内存池的初始内存块
   my_malloc_allocator() {}
 
   // 静态初始化构造函数
   static void initializer();
 
-  // 析构函数
-  ~my_malloc_allocator() { operator delete(memoryPoolPtr); }
+  // 容器把分配器当成员持有 析构时什么也不做
+  // 需要把空闲span还给系统时显式调用trim()或者设置trim_policy
+  ~my_malloc_allocator() {}
 
   // 内存分配的接口
   static void *allocate(size_t n);
@@ -69,6 +228,34 @@ public:
   // 内存释放接口
   static void deallocate(void *p, size_t size);
 
+  // 按alignment对齐的分配 alignment必须是2的幂
+  // 不超过MAX_ALIGN时从自然对齐足够的大小类别里分配 仍然走内存池
+  // 释放时要传入同样的size和alignment
+  static void *allocate(size_t n, size_t alignment);
+  static void deallocate(void *p, size_t size, size_t alignment);
+
+#if PAGEMAP_ON
+  // 不传大小的释放 p必须来自上面的allocate 不论当时是否指定了对齐
+  static void deallocate(void *p);
+#endif // PAGEMAP_ON
+
+  // 批量申请count个n字节的对象放进out 和逐个allocate得到的对象一样
+  // 先取线程缓存里的 再在一次加锁里从free_list整段摘下和从chunk连续切出
+  // 失败时已经拿到的对象会还回去 然后和allocate一样调用处理函数或者抛出异常
+  static void allocate_batch(size_t n, size_t count, void **out);
+  // 批量释放 ptrs里的对象都是n字节 其中的nullptr会被跳过
+  // 在锁外连成链 同一NUMA节点的一段只加一次锁挂回free_list
+  static void deallocate_batch(size_t n, size_t count, void *const *ptrs);
+
+  // 尝试在原地把p的大小从old_size改成new_size 成功时返回true p仍然有效
+  // 小对象新旧大小在同一个类别里时成功 直接映射的大对象用不移动的mremap
+  // 只用于没有指定对齐的对象 调试模式下只有大小不变时返回true
+  static bool try_expand(void *p, size_t old_size, size_t new_size);
+  // 和realloc一样 返回新地址 前min(old_size, new_size)个字节保持不变
+  // 先try_expand 直接映射的大对象再用mremap移动 否则申请 复制 释放
+  // 失败时和allocate一样 原来的对象不变
+  static void *reallocate(void *p, size_t old_size, size_t new_size);
+
   // 使用内存池创建智能指针
   template <typename T> static std::shared_ptr<T> make_shared_with_pool();
   template <typename T, typename... Args>
@@ -78,110 +265,598 @@ public:
   static std::shared_ptr<T> make_shared_with_pool();
   // 析构函数关闭内存池
 
+  // 输出每个大小类别的对象大小 每次切出的个数和内部碎片情况
+  static void print_size_classes(std::ostream &os);
+
+  // 把全部对象都在全局free_list上的span还给系统 返回归还的字节数
+  // keep_bytes是保留下来留给之后申请的空闲span字节数
+  // 线程缓存里的对象算作正在使用 无锁模式下不做归还 直接返回0
+  static size_t trim(size_t keep_bytes = 0);
+
+  // 自动归还内存的策略
+  // free_threshold: 全局free_list上空闲的字节数超过它时在释放路径上自动trim
+  //                 0表示不自动trim
+  // keep_bytes: 自动trim时传给trim的保留字节数
+  // interval_ms: 不为0时启动一个后台线程 每隔interval_ms毫秒trim一次
+  //              设回0后台线程在下一次醒来时退出
+  struct trim_policy {
+    size_t free_threshold;
+    size_t keep_bytes;
+    unsigned int interval_ms;
+  };
+  static void set_trim_policy(const trim_policy &policy);
+
+  // 每个大小类别的统计
+  // live_objects: 已经切出来并且正在被使用的对象
+  // free_objects: 挂在全局free_list和所有线程缓存上的对象
+  // cached_objects: free_objects中在线程缓存里的部分
+  // refills: free_list或者线程缓存为空时去补充的次数
+  // chunk_allocs: 从chunk切出新对象的次数
+  // reserved_bytes: 这个类别切出来的全部字节 used_bytes: 其中正在使用的字节
+  struct class_stats {
+    size_t size;
+    size_t live_objects;
+    size_t free_objects;
+    size_t cached_objects;
+    size_t refills;
+    size_t chunk_allocs;
+    size_t reserved_bytes;
+    size_t used_bytes;
+  };
+
+  // 整个内存池的统计
+  // heap_bytes/spans: 从系统申请的span
+  // system_bytes: 计入上限的字节数 即span加上大对象 limit_bytes: 上限 0表示不限制
+  // big_*: 超过MAX_BYTES直接走big_mem_allocate的申请
+  struct pool_stats {
+    bool enabled; // 编译时关掉统计的话只有heap_bytes spans和上限有效
+    size_t heap_bytes;
+    size_t spans;
+    size_t system_bytes;
+    size_t limit_bytes;
+    size_t big_allocs;
+    size_t big_frees;
+    size_t big_live_bytes;
+    class_stats classes[size_class_table::CLASS_COUNT];
+  };
+
+  // 取一份统计快照 无锁模式下各个数字之间可能有少许不一致
+  static void get_stats(pool_stats &stats);
+  // 以一行JSON输出统计快照 方便线上采集
+  static void dump_stats(std::ostream &os);
+
+  // NUMA节点选择 没有打开POOL_NUMA时只有节点0 set_thread_node什么也不做
+  // set_thread_node让当前线程之后的小对象分配都使用node节点的内存
+  // 线程缓存里已有的对象先还给原来的节点 通常在线程绑核之后调用一次
+  static void set_thread_node(int node);
+  static int thread_node();
+  // 系统中的NUMA节点个数
+  static int numa_node_count();
+
+  // 申请失败时的处理函数 用法和std::set_new_handler一样 返回之前的处理函数
+  // 内存池拿不到内存时(系统内存不足或者超过了set_memory_limit的上限)
+  // 先从更大的类别借空闲对象 再把完全空闲的span还回去腾出额度(无锁模式不归还)
+  // 还不行就在锁外调用处理函数然后重试 处理函数应该释放一些内存
+  // 或者抛出异常 没有设置处理函数时抛出std::bad_alloc
+  static custom_alloc_false_func
+  set_alloc_false_handler(custom_alloc_false_func func);
+
+  // 内存池向系统申请的总字节数上限 包括span和大对象 0表示不限制
+  // 调小时已经申请的内存不受影响 只是之后超出上限的申请会失败
+  static void set_memory_limit(size_t bytes);
+  static size_t get_memory_limit();
+
+  // 按大小类别输出还没有释放的对象 返回没有释放的对象个数
+  // 调试模式下程序退出时会自动调用一次 没有打开POOL_DEBUG时直接返回0
+  static size_t report_leaks(std::ostream &os);
+
 private:
+  // 按大小类别分配和释放 不经过调试模式的包装
+  static void *pool_allocate(size_t n, size_t alignment);
+  static void pool_deallocate(void *p, size_t size, size_t alignment);
+
   // 一级的内存分配直接封装new和free进行分配
   static void *big_mem_allocate(size_t n);
+  static void *big_mem_allocate(size_t n, size_t alignment);
+
+  // 打开POOL_PAGEMAP时大对象紧挨着的前面是big_header
+  // 对象前面一共big_head(alignment)字节 这样对象仍然按alignment对齐
+  struct big_header {
+    size_t size;
+    size_t alignment;
+  };
+  static size_t big_head(size_t alignment) {
+#if PAGEMAP_ON
+    return alignment > sizeof(big_header) ? alignment : sizeof(big_header);
+#else
+    (void)alignment;
+    return 0;
+#endif // PAGEMAP_ON
+  }
+
+  // 大对象是否直接mmap 由大小和对齐决定 释放时传入同样的参数就能判断
+  enum { BIG_MMAP_BYTES = 256 * 1024 };
+  static bool big_mapped(size_t n, size_t alignment) {
+    return BIG_MMAP_ON && alignment <= ALIGN && n >= BIG_MMAP_BYTES;
+  }
+#if BIG_MMAP_ON
+  // 用mremap把直接映射的大对象从old_size改成new_size 两个大小都要满足big_mapped
+  // may_move为false时只在原地调整 失败返回nullptr
+  static void *big_remap(void *p, size_t old_size, size_t new_size,
+                         bool may_move);
+#endif // BIG_MMAP_ON
+
+  // 给std::allocate_shared用的分配器 控制块和对象在同一次内存池申请里
+  // 这样每个智能指针只申请一次 不再用全局new单独申请控制块
+  // Construct为false时construct和destroy什么也不做 对应无参版本不构造对象
+  template <typename T, bool Construct> struct shared_allocator {
+    using value_type = T;
+    template <typename U> struct rebind {
+      using other = shared_allocator<U, Construct>;
+    };
+
+    shared_allocator() = default;
+    template <typename U>
+    shared_allocator(const shared_allocator<U, Construct> &) {}
+
+    T *allocate(size_t n) {
+      return static_cast<T *>(
+          my_malloc_allocator::allocate(n * sizeof(T), alignof(T)));
+    }
+    void deallocate(T *p, size_t n) {
+      my_malloc_allocator::deallocate(p, n * sizeof(T), alignof(T));
+    }
+
+    template <typename U, typename... Args>
+    void construct(U *p, Args &&...args) {
+      if constexpr (Construct)
+        ::new ((void *)p) U(std::forward<Args>(args)...);
+    }
+    template <typename U> void destroy(U *p) {
+      if constexpr (Construct)
+        p->~U();
+    }
+
+    template <typename U>
+    bool operator==(const shared_allocator<U, Construct> &) const {
+      return true;
+    }
+    template <typename U>
+    bool operator!=(const shared_allocator<U, Construct> &) const {
+      return false;
+    }
+  };
 
   // 二级分配
 #if DOUBLE_ALLOC_ON // 关闭二级内存分配器
   class small_mem_allocator {
   public:
     static void *small_mem_allocate(size_t n) {
-      // 找到对应的内存块
-      LOCK(&my_malloc_allocator::mtx);
-      volatile obj *temp = free_list[FREELIST_INDEX(n)];
-      if (temp == NULL) // 没有可以使用的空间了
-      {
-        void *r = refill(ROUND_UP(n));
-        UNLOCK(&my_malloc_allocator::mtx);
-        return r;
-      }
-      volatile obj *result = temp;
-      temp = result->free_list_link;
-      UNLOCK(&my_malloc_allocator::mtx);
+#if THREAD_CACHE_ON
+      // 先从本线程的缓存里取 取不到再批量从全局链表补充
+      size_t index = FREELIST_INDEX(n);
+      thread_cache *cache = local_cache();
+      if (cache == nullptr)
+        return global_allocate(n);
+      obj *result = cache->list[index];
+      if (result == nullptr)
+        return cache_refill(*cache, index);
+      cache->list[index] = result->free_list_link;
+      cache->set(index, cache->get(index) - 1);
       return (void *)result;
+#else
+      return global_allocate(n);
+#endif // THREAD_CACHE_ON
     }
   };
 
+  // 不经过线程缓存 直接从全局free_list(不够的话从chunk)取一个对象
+  static void *global_allocate(size_t n) {
+    // 找到对应的内存块
+    size_t node = current_node();
+    LIST_LOCK(&my_malloc_allocator::mtx);
+    obj *result = list_pop(node, FREELIST_INDEX(n));
+    if (result == nullptr) // 没有可以使用的空间了
+    {
+      CHUNK_LOCK(&my_malloc_allocator::mtx);
+      void *r = refill(node, ROUND_UP(n));
+      CHUNK_UNLOCK(&my_malloc_allocator::mtx);
+      LIST_UNLOCK(&my_malloc_allocator::mtx);
+      return r;
+    }
+    LIST_UNLOCK(&my_malloc_allocator::mtx);
+    return (void *)result;
+  }
+
   // 查看内存池的内存是否还有没有 没挂载道free_list上的
-  static void *refill(size_t n);
-  static char *chunk_alloc(size_t n, int &obj);
+  // node是使用哪个NUMA节点的free_list和chunk
+  static void *refill(size_t node, size_t n);
+  static char *chunk_alloc(size_t node, size_t n, int &obj);
+  // 把chunk里切不出对象的边角按对齐拆成几块挂到free_list上
+  static void chunk_leftover(size_t node, char *p, size_t bytes);
 
-  // 向上取整的函数
+  // 向上取整到所在类别的大小
   static size_t ROUND_UP(size_t n) {
-    return (((n + ALIGN - 1) / ALIGN) * ALIGN);
+    return size_classes.size[FREELIST_INDEX(n)];
   }
 
   static size_t FREELIST_INDEX(size_t bytes) {
-    return ((bytes + ALIGN - 1) / ALIGN - 1);
+    return size_classes.index[(bytes + ALIGN - 1) >> 3];
+  }
+
+  // 能装下bytes并且自然对齐不小于alignment的最小类别
+  // 4096的自然对齐是MAX_ALIGN 所以一定能找到
+  static size_t ALIGNED_INDEX(size_t bytes, size_t alignment) {
+    size_t index = FREELIST_INDEX(bytes);
+    while (size_classes.align[index] < alignment)
+      index++;
+    return index;
+  }
+
+  // 向下取整 找到不超过bytes的最大类别 用来回收chunk剩下的边角
+  static size_t FREELIST_FLOOR(size_t bytes) {
+    size_t index = FREELIST_INDEX(bytes);
+    return size_classes.size[index] > bytes ? index - 1 : index;
   }
 
 #endif // not defined(__DOUBLE_ALLOCATOR_OFF)
 
 #if DOUBLE_ALLOC_ON
-  enum { ALIGN = 8 };
-  enum { MAX_BYTES = 4096 };
-  enum { FREELIST_SIZE = MAX_BYTES / ALIGN };
+  enum { ALIGN = size_class_table::ALIGN };
+  enum { MAX_BYTES = size_class_table::MAX_BYTES };
+  enum { FREELIST_SIZE = size_class_table::CLASS_COUNT };
+#if NUMA_ON
+  enum { NUMA_NODES = POOL_NUMA_NODES };
+#else
+  enum { NUMA_NODES = 1 };
+#endif // NUMA_ON
 
   union obj {
     union obj *free_list_link;
     char client_data[1];
   };
 
-  // 这是一个数组
-  static volatile obj *free_list[FREELIST_SIZE];
+#if LOCK_FREE_ON
+  // 无锁模式下每个free_list是一个Treiber栈
+  // 栈顶的低48位存指针 高16位存版本号 每次修改栈顶版本号加一
+  // 这样节点被别的线程弹出又压回的时候CAS会失败 避免ABA问题
+  using tagged_ptr = uintptr_t;
+  static_assert(sizeof(void *) == 8, "tagged free list needs 64-bit pointers");
+  enum : tagged_ptr { TAG_SHIFT = 48 };
+  static constexpr tagged_ptr PTR_MASK = (tagged_ptr(1) << TAG_SHIFT) - 1;
+
+  static obj *tag_pointer(tagged_ptr t) { return (obj *)(t & PTR_MASK); }
+  static tagged_ptr make_tagged(obj *p, tagged_ptr old) {
+    return (tagged_ptr)p | ((old & ~PTR_MASK) + (tagged_ptr(1) << TAG_SHIFT));
+  }
+
+  static std::atomic<tagged_ptr> free_list[NUMA_NODES][FREELIST_SIZE];
+#else
+  // 每个NUMA节点一组 没有打开NUMA时只有一组
+  static volatile obj *free_list[NUMA_NODES][FREELIST_SIZE];
+#endif // LOCK_FREE_ON
+
+  // 从node节点的第index条free_list弹出一个节点 为空返回nullptr
+  // 把first到last这一段已经连好的节点整段压回node节点的第index条free_list
+  // 互斥锁模式下调用者要持有LIST_LOCK 无锁模式下可以直接调用
+  static obj *list_pop(size_t node, size_t index);
+  static void list_push(size_t node, size_t index, obj *first, obj *last,
+                        unsigned int nobj);
+  // 最多弹出count个节点放进out 返回弹出的个数 加锁要求和list_pop一样
+  static size_t list_pop_batch(size_t node, size_t index, void **out,
+                               size_t count);
+
+  // 小对象的批量申请和释放 n不超过MAX_BYTES
+  // 申请不到时返回已经拿到的个数 不会调用处理函数
+  static size_t small_allocate_batch(size_t n, size_t count, void **out);
+  static void small_deallocate_batch(size_t n, size_t count,
+                                     void *const *ptrs);
+
+  // 堆内存按span从系统申请 每个span大小固定并且按大小对齐
+  // 这样任意一个对象地址清掉低位就能找到所在的span
+  // span头部记录链表指针 trim的时候统计span里有多少字节挂在free_list上
+  // 等于span的可用大小说明整个span都空闲 可以摘掉这些节点并还给系统
+  enum { SPAN_SHIFT = 16 };
+  enum { SPAN_BYTES = 1 << SPAN_SHIFT };
+  enum { SPAN_HEADER = 64 };
+  enum { SPAN_USABLE = SPAN_BYTES - SPAN_HEADER };
+
+  struct span {
+    span *next;
+    span *prev;
+    size_t free_bytes; // trim时统计出的空闲字节数
+    size_t node;       // 所属的NUMA节点
+    size_t cls;        // 打开POOL_PAGEMAP时span里对象的类别
+    bool release;      // trim时标记这个span要被归还
+  };
+
+  static span *span_of(void *p) {
+    return (span *)((uintptr_t)p & ~(uintptr_t)(SPAN_BYTES - 1));
+  }
+
+  // 对象所在span属于哪个节点 没有打开NUMA时不读span头
+  static size_t node_of(void *p) {
+#if NUMA_ON
+    return span_of(p)->node;
+#else
+    (void)p;
+    return 0;
+#endif // NUMA_ON
+  }
+
+  // 当前线程使用的节点 第一次调用时按所在CPU决定
+  static size_t &thread_node_slot() {
+    static thread_local size_t node = size_t(-1);
+    return node;
+  }
+  static size_t current_node() {
+#if NUMA_ON
+    size_t &node = thread_node_slot();
+    if (node == size_t(-1))
+      node = detect_node();
+    return node;
+#else
+    return 0;
+#endif // NUMA_ON
+  }
+  static size_t detect_node();
+
+  // 新span属于node节点 打开POOL_PAGEMAP时只用来切第index个类别的对象
+  static span *span_alloc(size_t node, size_t index); // 失败返回nullptr
+  static void span_free(span *s);
+
+  // 全部对象都空闲时span挂在free_list上的字节数
+  // 打开POOL_PAGEMAP时span末尾切不出一个对象的部分不会挂到free_list上
+  static size_t span_capacity(span *s) {
+#if PAGEMAP_ON
+    size_t size = size_classes.size[s->cls];
+    return SPAN_USABLE / size * size;
+#else
+    (void)s;
+    return SPAN_USABLE;
+#endif // PAGEMAP_ON
+  }
+
+  // 每个节点正在切分的chunk 打开POOL_PAGEMAP时每个类别各有一个
+#if PAGEMAP_ON
+  enum { CHUNK_LISTS = FREELIST_SIZE };
+#else
+  enum { CHUNK_LISTS = 1 };
+#endif // PAGEMAP_ON
+  static size_t chunk_list(size_t index) {
+#if PAGEMAP_ON
+    return index;
+#else
+    (void)index;
+    return 0;
+#endif // PAGEMAP_ON
+  }
+
+#if PAGEMAP_ON
+  // 以span编号(地址右移SPAN_SHIFT位)为键的两层基数树 按48位地址划分
+  // 叶子给每个span一个字节 0表示不是内存池的span 否则是类别加一
+  // 一个叶子覆盖4GB地址空间 第一次用到时申请 之后不再释放
+  // 只在持有锁的span_alloc/span_free里写 读不加锁
+  enum { PAGEMAP_LEAF_BITS = 16 };
+  enum { PAGEMAP_ROOT_BITS = 48 - SPAN_SHIFT - PAGEMAP_LEAF_BITS };
+  static std::atomic<unsigned char *> pagemap_root[1 << PAGEMAP_ROOT_BITS];
+
+  // p所在span的类别 不是内存池的span时返回FREELIST_SIZE
+  static size_t pagemap_class(const void *p) {
+    uintptr_t key = (uintptr_t)p >> SPAN_SHIFT;
+    uintptr_t root = key >> PAGEMAP_LEAF_BITS;
+    if (root >= (uintptr_t(1) << PAGEMAP_ROOT_BITS))
+      return FREELIST_SIZE;
+    unsigned char *leaf = pagemap_root[root].load(std::memory_order_acquire);
+    if (leaf == nullptr)
+      return FREELIST_SIZE;
+    unsigned char v = leaf[key & ((uintptr_t(1) << PAGEMAP_LEAF_BITS) - 1)];
+    return v == 0 ? FREELIST_SIZE : v - 1;
+  }
+  static bool pagemap_set(span *s, unsigned char value);
+#endif // PAGEMAP_ON
+  static size_t trim_locked(size_t keep_bytes);
+
+  // 向系统申请n字节之前先占用额度 超过上限返回false 归还时释放额度
+  static bool reserve_bytes(size_t n) {
+    size_t limit = limit_bytes.load(std::memory_order_relaxed);
+    size_t used = system_bytes.fetch_add(n, std::memory_order_relaxed) + n;
+    if (limit != 0 && used > limit) {
+      system_bytes.fetch_sub(n, std::memory_order_relaxed);
+      return false;
+    }
+    return true;
+  }
+  static void release_bytes(size_t n) {
+    system_bytes.fetch_sub(n, std::memory_order_relaxed);
+  }
+  // 申请失败 有处理函数就调用它 没有就抛出std::bad_alloc 调用时不能持有锁
+  static void alloc_failed();
+
+  static std::atomic<size_t> system_bytes;
+  static std::atomic<size_t> limit_bytes;
+  static std::atomic<custom_alloc_false_func> alloc_false_handler;
+#if !LOCK_FREE_ON
+  // 释放路径上检查是否达到自动trim的阈值 调用者要持有LIST_LOCK
+  static void maybe_trim() {
+    if (trim_setting.free_threshold != 0 && free_bytes > trim_mark) {
+      trim_locked(trim_setting.keep_bytes);
+      trim_mark = free_bytes + trim_setting.free_threshold;
+    }
+  }
+#endif // !LOCK_FREE_ON
+
+#if ARENA_ON
+  // 每次向系统保留ARENA_BYTES的虚拟内存 实际用到的页才会占用物理内存
+  // trim归还的span只做MADV_DONTNEED 然后放进free_spans等待复用
+  // 直接munmap会把大页拆散
+  static constexpr size_t ARENA_BYTES = size_t(64) << 20;
+  static constexpr size_t HUGE_PAGE_BYTES = size_t(2) << 20;
+
+  static char *arena_cur; // 当前保留区域中还没切出去的部分
+  static char *arena_end;
+  static span *free_spans; // 已经归还给系统等待复用的span 用next连接
+#endif // ARENA_ON
+
+#if defined(THREAD_ON)
+  using stat_counter = std::atomic<size_t>;
+#else
+  using stat_counter = size_t;
+#endif // defined(THREAD_ON)
+
+#if STATS_ON
+  static stat_counter class_carved[FREELIST_SIZE]; // 切出来的对象个数
+  static stat_counter class_free[FREELIST_SIZE];   // 全局free_list上的个数
+  static stat_counter class_refills[FREELIST_SIZE];
+  static stat_counter class_chunk_allocs[FREELIST_SIZE];
+  static stat_counter big_allocs;
+  static stat_counter big_frees;
+  static stat_counter big_live_bytes;
+#endif // STATS_ON
+
+#if DEBUG_ON
+  // 调试模式下一次申请的布局
+  // | free_list_link | 前红区 | debug_header | DEBUG_GUARD字节红区 | 对象 | 后红区 |
+  // 对象前面的部分一共debug_front(alignment)字节 后红区DEBUG_GUARD字节
+  // debug_header紧挨着对象前面的红区 只知道对象地址也能找到它
+  // 释放时在free_list_link后面再写一份 再次申请时用它检查释放后的填充
+  // free_list_link留给内存池挂链表用 不填充也不标记成不可访问
+  enum { DEBUG_GUARD = 16 };
+  enum : uint32_t { DEBUG_LIVE = 0x11fe11feu, DEBUG_FREED = 0xdeadf4eeu };
+  enum : unsigned char {
+    DEBUG_GUARD_BYTE = 0xab, // 红区
+    DEBUG_NEW_BYTE = 0xcd,   // 刚申请还没写过的对象
+    DEBUG_FREED_BYTE = 0xdd  // 已经释放的对象
+  };
+
+  struct debug_header {
+    uint32_t state;     // DEBUG_LIVE或者DEBUG_FREED
+    uint32_t alignment; // 申请时的对齐
+    size_t size;        // 使用者申请的字节数
+  };
+
+  // 对象前面的字节数 放得下链表指针 对象头和一段红区 并且是alignment的倍数
+  static size_t debug_front(size_t alignment) {
+    size_t front = sizeof(obj) + sizeof(debug_header) + DEBUG_GUARD;
+    return (front + alignment - 1) & ~(alignment - 1);
+  }
+  static debug_header *debug_header_of(void *p) {
+    return (debug_header *)((char *)p - DEBUG_GUARD) - 1;
+  }
+  static debug_header *debug_freed_header(char *block) {
+    return (debug_header *)(block + sizeof(obj));
+  }
+
+  static void *debug_allocate(size_t n, size_t alignment);
+  static void debug_deallocate(void *p, size_t size, size_t alignment);
+  // 输出错误并abort
+  [[noreturn]] static void debug_fail(const char *what, const void *p,
+                                      size_t size);
+
+  // 还没释放的对象 按块所在的大小类别统计 最后一项是超过MAX_BYTES的块
+  static stat_counter debug_live[FREELIST_SIZE + 1];
+  static stat_counter debug_live_bytes[FREELIST_SIZE + 1];
+#endif // DEBUG_ON
+
+  static span *span_list;   // 所有span组成的双向链表
+  static size_t free_bytes; // 全局free_list上的空闲字节数 无锁模式下不统计
+  static size_t trim_mark;  // 空闲字节数超过它时触发自动trim
+  static trim_policy trim_setting;
+  static bool trim_thread_running;
 
   static size_t heap_size; // 当前管理的堆内存总量
 
   static size_t page_size;
   static char *memoryPoolPtr;
 
-  static char *start_free;
-  static char *end_free;
+  static char *start_free[NUMA_NODES][CHUNK_LISTS];
+  static char *end_free[NUMA_NODES][CHUNK_LISTS];
 
   // 对于 多线程模式可能修改的变量是free_list,heap_szie,start_free,end_free
   // 所以在修改变量的时候要加上互斥锁
-#if defined(THREAD_ON) && defined(_PTHREAD_H)
+#if defined(THREAD_ON)
   static pthread_mutex_t mtx;
-#endif // defined(THREAD_ON) && defined(_PTHREAD_H)
+#endif // defined(THREAD_ON)
+
+#if THREAD_CACHE_ON
+  // 线程本地缓存 每个大小类别一条单链表 count记录链表上的节点个数
+  // 线程退出的时候析构函数把缓存的内存全部归还到全局free_list
+  // 打开NUMA时缓存只收本节点的对象 别的节点的对象直接还给所属节点
+  // 所有缓存挂在caches链表上 统计的时候要读别的线程的count
+  // count只有所属线程会修改 所以用relaxed的load/store就够了
+  struct thread_cache {
+    obj *list[FREELIST_SIZE];
+    std::atomic<unsigned int> count[FREELIST_SIZE];
+    thread_cache *next;
+    thread_cache *prev;
+    size_t node; // 缓存里的对象都来自这个节点
+
+    thread_cache();
+    ~thread_cache();
+
+    unsigned int get(size_t index) const {
+      return count[index].load(std::memory_order_relaxed);
+    }
+    void set(size_t index, unsigned int n) {
+      count[index].store(n, std::memory_order_relaxed);
+    }
+  };
+
+  static thread_cache *caches;
+
+  // 缓存析构之后同一线程里更晚执行的析构函数还可能申请和释放
+  // (替换了全局operator new时很常见) 这时不能再访问已经析构的缓存
+  // 析构的状态放在可以平凡析构的thread_local里 线程退出的整个过程都能读
+  static bool &cache_destroyed() {
+    static thread_local bool destroyed = false;
+    return destroyed;
+  }
+
+  // 本线程的缓存 已经析构时返回nullptr 调用方直接使用全局free_list
+  static thread_cache *local_cache() {
+    if (cache_destroyed())
+      return nullptr;
+    static thread_local thread_cache cache;
+    return &cache;
+  }
+
+  // 一次在线程缓存和全局链表之间搬运的节点个数
+  static unsigned int batch_count(size_t index) {
+    unsigned int batch = size_classes.nobj[index];
+    return batch > 32 ? 32 : batch;
+  }
+
+  // 从全局链表(不够的话从chunk)批量取节点放进缓存 并返回其中一个
+  static void *cache_refill(thread_cache &cache, size_t index);
+  // 把缓存链表头部的nobj个节点整段挂回全局链表
+  static void cache_release(thread_cache &cache, size_t index,
+                            unsigned int nobj);
+#endif // THREAD_CACHE_ON
 #endif // DOUBLE_ALLOC_ON
 };
 
-// 无参构造智能指针
+// 无参构造智能指针 和原来一样不调用构造和析构
 template <typename T>
 std::shared_ptr<T> my_malloc_allocator::make_shared_with_pool() {
-  T *ptmp = (T *)my_malloc_allocator::allocate(sizeof(T));
-  // new(ptmp) T();
-  return std::shared_ptr<T>(ptmp, [](T *ptr) {
-    // ptr->~T();
-    my_malloc_allocator::deallocate((void *)ptr, sizeof(T));
-  });
+  return std::allocate_shared<T>(shared_allocator<T, false>());
 }
 
-
 template <typename T, typename... Args>
 std::shared_ptr<T>
 my_malloc_allocator::make_shared_with_pool(Args... args) {
-  T *ptmp = (T *)my_malloc_allocator::allocate(sizeof(T));
-  new (ptmp) T(std::forward<Args>(args)...);
-  return std::shared_ptr<T>(ptmp, [](T *ptr) {
-    ptr->~T();
-    my_malloc_allocator::deallocate((void *)ptr, sizeof(T));
-  });
+  return std::allocate_shared<T>(shared_allocator<T, true>(),
+                                 std::forward<Args>(args)...);
 }
 
-
-
-
+// 数组版本 控制块后面跟着N个T的空间 再用别名构造指向第一个元素
 template <typename T, size_t N>
 std::shared_ptr<T> my_malloc_allocator::make_shared_with_pool() {
-  size_t size = N;
-  T *ptmp = (T *)my_malloc_allocator::allocate(sizeof(T) * size);
-  return std::shared_ptr<T>(ptmp, [size](T *ptr) {
-    my_malloc_allocator::deallocate((void *)ptr, sizeof(T) * size);
-  });
+  struct storage {
+    alignas(T) unsigned char bytes[sizeof(T) * N];
+  };
+  std::shared_ptr<storage> block =
+      std::allocate_shared<storage>(shared_allocator<storage, false>());
+  return std::shared_ptr<T>(block, reinterpret_cast<T *>(block->bytes));
 }
 
- 
-
 #endif // _MEMORYPOOL_H_
\ No newline at end of file
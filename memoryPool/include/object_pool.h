@@ -0,0 +1,182 @@
+#ifndef _OBJECT_POOL_H_
+#define _OBJECT_POOL_H_
+// 固定大小对象的slab分配器 给链表和树的节点用
+// 每个slab是一块按SlabBytes对齐的大内存 从my_malloc_allocator申请
+// 槽位紧密排列 申请时先取空闲链表 没有就在当前slab里向后切 都是O(1)
+// destroy_all()一次把所有slab还回去 不需要逐个释放节点
+// 不是线程安全的 每个容器各自持有一个
+// 例如 object_pool<node> pool; node *p = pool.create(1); pool.destroy(p);
+
+#include "./memoryPool.h"
+#include <cstddef>
+#include <cstdint>
+#include <new>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+template <typename T, size_t SlabBytes = 64 * 1024> class object_pool {
+public:
+  object_pool() = default;
+  object_pool(const object_pool &) = delete;
+  object_pool &operator=(const object_pool &) = delete;
+
+  object_pool(object_pool &&other) noexcept { swap(other); }
+  object_pool &operator=(object_pool &&other) noexcept {
+    if (this != &other) {
+      destroy_all();
+      swap(other);
+    }
+    return *this;
+  }
+
+  ~object_pool() { destroy_all(); }
+
+  // 只拿一个槽位 不构造对象
+  T *allocate() {
+    if (free_list != nullptr) {
+      slot *p = free_list;
+      free_list = p->next;
+      live++;
+      return reinterpret_cast<T *>(p);
+    }
+    if (cur == end)
+      new_slab();
+    T *p = reinterpret_cast<T *>(cur);
+    cur += SLOT_BYTES;
+    live++;
+    return p;
+  }
+
+  // 把槽位放回空闲链表 不析构对象
+  void deallocate(T *p) {
+    slot *s = reinterpret_cast<slot *>(p);
+    s->next = free_list;
+    free_list = s;
+    live--;
+  }
+
+  template <typename... Args> T *create(Args &&...args) {
+    T *p = allocate();
+    try {
+      ::new ((void *)p) T(std::forward<Args>(args)...);
+    } catch (...) {
+      deallocate(p);
+      throw;
+    }
+    return p;
+  }
+
+  void destroy(T *p) {
+    p->~T();
+    deallocate(p);
+  }
+
+  // 析构所有还活着的对象并归还全部slab
+  // T可以平凡析构时直接归还 否则先用空闲链表标记出空槽 再析构其余的槽
+  void destroy_all() {
+    if constexpr (!std::is_trivially_destructible_v<T>) {
+      if (live != 0)
+        destroy_live();
+    }
+    release();
+  }
+
+  // 不析构对象直接归还全部slab 调用者保证对象不需要析构
+  void release() {
+    while (slabs != nullptr) {
+      slab *next = slabs->next;
+      my_malloc_allocator::deallocate(slabs, SlabBytes, SlabBytes);
+      slabs = next;
+    }
+    free_list = nullptr;
+    cur = end = nullptr;
+    live = 0;
+    slab_count = 0;
+  }
+
+  size_t size() const { return live; }
+  static constexpr size_t slot_bytes() { return SLOT_BYTES; }
+  static constexpr size_t slots_per_slab() { return SLOTS; }
+
+  void swap(object_pool &other) noexcept {
+    std::swap(slabs, other.slabs);
+    std::swap(free_list, other.free_list);
+    std::swap(cur, other.cur);
+    std::swap(end, other.end);
+    std::swap(live, other.live);
+    std::swap(slab_count, other.slab_count);
+  }
+
+private:
+  union slot {
+    slot *next;
+  };
+
+  // index是slab的序号 destroy_all时用来定位标记数组
+  struct slab {
+    slab *next;
+    size_t index;
+  };
+
+  // 槽位至少放得下一个指针 并且满足T的对齐
+  static constexpr size_t SLOT_ALIGN =
+      alignof(T) > alignof(slot) ? alignof(T) : alignof(slot);
+  static constexpr size_t SLOT_SIZE =
+      sizeof(T) > sizeof(slot) ? sizeof(T) : sizeof(slot);
+  static constexpr size_t SLOT_BYTES =
+      (SLOT_SIZE + SLOT_ALIGN - 1) / SLOT_ALIGN * SLOT_ALIGN;
+  // slab头单独占一条cache line 第一个槽位从cache line开头开始
+  static constexpr size_t HEADER_BYTES = SLOT_ALIGN > 64 ? SLOT_ALIGN : 64;
+  static constexpr size_t SLOTS = (SlabBytes - HEADER_BYTES) / SLOT_BYTES;
+
+  static_assert((SlabBytes & (SlabBytes - 1)) == 0,
+                "SlabBytes必须是2的幂");
+  static_assert(SLOTS >= 1, "SlabBytes太小 放不下一个对象");
+
+  void new_slab() {
+    slab *s = static_cast<slab *>(
+        my_malloc_allocator::allocate(SlabBytes, SlabBytes));
+    s->next = slabs;
+    s->index = slab_count++;
+    slabs = s;
+    cur = reinterpret_cast<char *>(s) + HEADER_BYTES;
+    end = cur + SLOTS * SLOT_BYTES;
+  }
+
+  static slab *slab_of(const void *p) {
+    return reinterpret_cast<slab *>(reinterpret_cast<uintptr_t>(p) &
+                                    ~uintptr_t(SlabBytes - 1));
+  }
+
+  static size_t slot_index(const void *p) {
+    return ((reinterpret_cast<uintptr_t>(p) & (SlabBytes - 1)) -
+            HEADER_BYTES) /
+           SLOT_BYTES;
+  }
+
+  // 先遍历一遍空闲链表做标记 再析构没有标记的槽位
+  // 最新的slab只用到cur 之前的slab都是满的
+  void destroy_live() {
+    std::vector<unsigned char> is_free(slab_count * SLOTS);
+    for (slot *f = free_list; f != nullptr; f = f->next)
+      is_free[slab_of(f)->index * SLOTS + slot_index(f)] = 1;
+    for (slab *s = slabs; s != nullptr; s = s->next) {
+      char *first = reinterpret_cast<char *>(s) + HEADER_BYTES;
+      char *last = s == slabs ? cur : first + SLOTS * SLOT_BYTES;
+      unsigned char *mark = &is_free[s->index * SLOTS];
+      for (char *p = first; p != last; p += SLOT_BYTES, mark++)
+        if (!*mark)
+          reinterpret_cast<T *>(p)->~T();
+    }
+  }
+
+  slab *slabs = nullptr;
+  slot *free_list = nullptr;
+  char *cur = nullptr;
+  char *end = nullptr;
+  size_t live = 0;
+  size_t slab_count = 0;
+};
+
+#endif // _OBJECT_POOL_H_
@@ -0,0 +1,59 @@
+#ifndef _POOL_ALLOCATOR_H_
+#define _POOL_ALLOCATOR_H_
+// 把my_malloc_allocator包装成满足C++17 Allocator要求的分配器
+// 这样std::vector std::map std::unordered_map std::list都可以直接使用内存池
+// 例如 std::map<int, int, std::less<int>, pool_allocator<std::pair<const int, int>>>
+
+#include "./memoryPool.h"
+#include <cstddef>
+#include <limits>
+#include <new>
+#include <type_traits>
+
+template <typename T> class pool_allocator {
+public:
+  using value_type = T;
+  using size_type = std::size_t;
+  using difference_type = std::ptrdiff_t;
+
+  // 内存池是全局的 任意两个pool_allocator都可以释放对方申请的内存
+  using propagate_on_container_copy_assignment = std::true_type;
+  using propagate_on_container_move_assignment = std::true_type;
+  using propagate_on_container_swap = std::true_type;
+  using is_always_equal = std::true_type;
+
+  template <typename U> struct rebind {
+    using other = pool_allocator<U>;
+  };
+
+  pool_allocator() noexcept = default;
+  template <typename U> pool_allocator(const pool_allocator<U> &) noexcept {}
+
+  T *allocate(size_type n) {
+    if (n > max_size())
+      throw std::bad_array_new_length();
+    // 对齐要求高的类型从自然对齐足够的大小类别里分配
+    return static_cast<T *>(
+        my_malloc_allocator::allocate(n * sizeof(T), alignof(T)));
+  }
+
+  void deallocate(T *p, size_type n) noexcept {
+    my_malloc_allocator::deallocate(p, n * sizeof(T), alignof(T));
+  }
+
+  size_type max_size() const noexcept {
+    return std::numeric_limits<size_type>::max() / sizeof(T);
+  }
+};
+
+template <typename T, typename U>
+bool operator==(const pool_allocator<T> &, const pool_allocator<U> &) noexcept {
+  return true;
+}
+
+template <typename T, typename U>
+bool operator!=(const pool_allocator<T> &, const pool_allocator<U> &) noexcept {
+  return false;
+}
+
+#endif // _POOL_ALLOCATOR_H_
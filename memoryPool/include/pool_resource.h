@@ -0,0 +1,138 @@
+#ifndef _POOL_RESOURCE_H_
+#define _POOL_RESOURCE_H_
+// 基于内存池的std::pmr::memory_resource实现
+// pool_memory_resource 直接转发给my_malloc_allocator 可以和任何pmr容器配合
+// pool_monotonic_resource 只向前切分内存 释放是空操作 析构或release时整体归还
+// 例如 std::pmr::map<int, int> m(pool_resource());
+
+#include "./memoryPool.h"
+#include <cstddef>
+#include <cstdint>
+#include <memory_resource>
+#include <new>
+
+class pool_memory_resource : public std::pmr::memory_resource {
+protected:
+  void *do_allocate(size_t bytes, size_t alignment) override {
+    return my_malloc_allocator::allocate(bytes, alignment);
+  }
+
+  void do_deallocate(void *p, size_t bytes, size_t alignment) override {
+    my_malloc_allocator::deallocate(p, bytes, alignment);
+  }
+
+  // 内存池是全局的 所有pool_memory_resource都可以互相释放
+  bool do_is_equal(const std::pmr::memory_resource &other) const
+      noexcept override {
+    return dynamic_cast<const pool_memory_resource *>(&other) != nullptr;
+  }
+};
+
+// 全局唯一的内存池资源 和std::pmr::new_delete_resource()的用法一样
+inline pool_memory_resource *pool_resource() noexcept {
+  static pool_memory_resource resource;
+  return &resource;
+}
+
+// 单调增长的资源 和chunk_alloc一样用start_free/end_free两个指针切分当前块
+// 当前块不够时不回收剩下的边角 直接向upstream要一块两倍大小的新块
+// 适合一次性建好之后整体销毁的容器 比如解析时临时建的树
+class pool_monotonic_resource : public std::pmr::memory_resource {
+public:
+  explicit pool_monotonic_resource(
+      size_t initial_size = size_class_table::REFILL_BYTES,
+      std::pmr::memory_resource *upstream = pool_resource())
+      : upstream(upstream), next_size(initial_size) {
+    if (next_size < sizeof(block))
+      next_size = sizeof(block);
+    initial_next = next_size;
+  }
+
+  // 先用调用者提供的缓冲区 用完之后再向upstream申请
+  pool_monotonic_resource(void *buffer, size_t size,
+                          std::pmr::memory_resource *upstream = pool_resource())
+      : upstream(upstream), start_free(static_cast<char *>(buffer)),
+        end_free(static_cast<char *>(buffer) + size), next_size(size * 2),
+        initial_buffer(static_cast<char *>(buffer)), initial_bytes(size) {
+    if (next_size < size_class_table::REFILL_BYTES)
+      next_size = size_class_table::REFILL_BYTES;
+    initial_next = next_size;
+  }
+
+  pool_monotonic_resource(const pool_monotonic_resource &) = delete;
+  pool_monotonic_resource &operator=(const pool_monotonic_resource &) = delete;
+
+  ~pool_monotonic_resource() override { release(); }
+
+  // 把所有从upstream申请的块一次性还回去
+  // 和std::pmr::monotonic_buffer_resource一样回到构造时的状态
+  // 调用者提供的缓冲区重新从头使用 下一块的大小也恢复成初始值
+  void release() {
+    while (blocks) {
+      block *next = blocks->next;
+      upstream->deallocate(blocks, blocks->bytes, alignof(block));
+      blocks = next;
+    }
+    start_free = initial_buffer;
+    end_free = initial_buffer + initial_bytes;
+    next_size = initial_next;
+  }
+
+  std::pmr::memory_resource *upstream_resource() const { return upstream; }
+
+protected:
+  void *do_allocate(size_t bytes, size_t alignment) override {
+    char *result = align_up(start_free, alignment);
+    if (result == nullptr || result + bytes > end_free) {
+      new_block(bytes + alignment);
+      result = align_up(start_free, alignment);
+    }
+    start_free = result + bytes;
+    return result;
+  }
+
+  // 单调资源不回收单个对象
+  void do_deallocate(void *, size_t, size_t) override {}
+
+  bool do_is_equal(const std::pmr::memory_resource &other) const
+      noexcept override {
+    return this == &other;
+  }
+
+private:
+  // 每一块的开头记录块的大小和下一块 方便release时归还
+  struct block {
+    block *next;
+    size_t bytes;
+  };
+
+  static char *align_up(char *p, size_t alignment) {
+    uintptr_t v = reinterpret_cast<uintptr_t>(p);
+    return reinterpret_cast<char *>((v + alignment - 1) & ~(alignment - 1));
+  }
+
+  void new_block(size_t min_bytes) {
+    size_t bytes = next_size;
+    while (bytes - sizeof(block) < min_bytes)
+      bytes *= 2;
+    block *b = static_cast<block *>(upstream->allocate(bytes, alignof(block)));
+    b->next = blocks;
+    b->bytes = bytes;
+    blocks = b;
+    start_free = reinterpret_cast<char *>(b + 1);
+    end_free = reinterpret_cast<char *>(b) + bytes;
+    next_size = bytes * 2;
+  }
+
+  std::pmr::memory_resource *upstream;
+  block *blocks = nullptr;
+  char *start_free = nullptr;
+  char *end_free = nullptr;
+  size_t next_size;
+  // 构造时的缓冲区和第一块的大小 release之后恢复
+  char *initial_buffer = nullptr;
+  size_t initial_bytes = 0;
+  size_t initial_next;
+};
+
+#endif // _POOL_RESOURCE_H_
@@ -0,0 +1,453 @@
+#include "../../my_vector/include/my_vector.h"
+#include "../include/memoryPool.h"
+#include "../include/pool_allocator.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <list>
+#include <map>
+#include <string>
+#include <thread>
+#include <vector>
+
+#if defined(__unix__)
+#include <sys/wait.h>
+#include <unistd.h>
+#endif // defined(__unix__)
+
+// 分配器的基准测试 每个场景分别用内存池和glibc malloc各跑一次
+// 输出每秒操作数 申请延迟的p50/p99(抽样) 以及场景里RSS的峰值增量
+//   size_class/N  单线程 每个大小类别连续申请一批再倒序释放
+//   cross_thread  生产者线程申请 通过队列交给消费者线程释放
+//   churn/T       T个线程 各自维护一组槽位 随机替换成随机大小的对象
+//   m_vector      m_vector<long>不断push_back 扩容时整块申请和释放
+//   std_map       std::map插入和销毁 pool_allocator对比std::allocator
+//   std_list      std::list在头尾插入和弹出
+// 每个场景在fork出的子进程里跑 峰值RSS互不影响 结果通过管道传回来
+// 用法: ./alloc_bench [场景名前缀] [规模倍数]
+
+namespace {
+
+// 内存池和malloc都包装成my_malloc_allocator的静态接口
+// 这样同一份场景代码可以用模板参数切换 m_vector也可以直接使用
+struct pool_backend {
+  static const char *name() { return "pool"; }
+  static void initializer() { my_malloc_allocator::initializer(); }
+  static void *allocate(size_t n) { return my_malloc_allocator::allocate(n); }
+  static void deallocate(void *p, size_t n) {
+    my_malloc_allocator::deallocate(p, n);
+  }
+  template <typename T> using std_allocator = pool_allocator<T>;
+};
+
+struct malloc_backend {
+  static const char *name() { return "malloc"; }
+  static void initializer() {}
+  static void *allocate(size_t n) {
+    void *p = std::malloc(n);
+    if (p == nullptr)
+      throw std::bad_alloc();
+    return p;
+  }
+  static void deallocate(void *p, size_t) { std::free(p); }
+  template <typename T> using std_allocator = std::allocator<T>;
+};
+
+struct bench_result {
+  double ops;
+  double seconds;
+  double p50_ns;
+  double p99_ns;
+  double peak_rss_mb;
+};
+
+using clock_type = std::chrono::steady_clock;
+
+// 每SAMPLE_EVERY次申请记录一次耗时 计时本身的开销不至于淹没申请
+enum { SAMPLE_EVERY = 8 };
+
+// 每个线程自己的延迟样本 场景结束后合并
+struct latency_log {
+  std::vector<unsigned int> samples;
+  size_t tick = 0;
+
+  latency_log() { samples.reserve(1 << 16); }
+
+  bool want() { return ++tick % SAMPLE_EVERY == 0; }
+  void add(clock_type::time_point begin) {
+    auto ns = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                  clock_type::now() - begin)
+                  .count();
+    samples.push_back((unsigned int)std::min<long long>(ns, 0xffffffffu));
+  }
+};
+
+// 计时申请一个对象 抽中的那次记录延迟
+template <typename Backend>
+inline void *timed_allocate(latency_log &log, size_t n) {
+  if (!log.want())
+    return Backend::allocate(n);
+  auto begin = clock_type::now();
+  void *p = Backend::allocate(n);
+  log.add(begin);
+  return p;
+}
+
+// 简单的xorshift 每个线程一个 保证两个后端看到的序列完全一样
+struct rng {
+  unsigned long long s;
+  explicit rng(unsigned long long seed) : s(seed * 0x9e3779b97f4a7c15ull + 1) {}
+  unsigned long long next() {
+    s ^= s << 13;
+    s ^= s >> 7;
+    s ^= s << 17;
+    return s;
+  }
+};
+
+// 单生产者单消费者的环形队列 生产者和消费者各自只写自己的下标
+struct spsc_queue {
+  enum { CAPACITY = 1024 };
+  void *slots[CAPACITY];
+  alignas(64) std::atomic<size_t> head{0};
+  alignas(64) std::atomic<size_t> tail{0};
+
+  bool push(void *p) {
+    size_t t = tail.load(std::memory_order_relaxed);
+    if (t - head.load(std::memory_order_acquire) == CAPACITY)
+      return false;
+    slots[t % CAPACITY] = p;
+    tail.store(t + 1, std::memory_order_release);
+    return true;
+  }
+  void *pop() {
+    size_t h = head.load(std::memory_order_relaxed);
+    if (h == tail.load(std::memory_order_acquire))
+      return nullptr;
+    void *p = slots[h % CAPACITY];
+    head.store(h + 1, std::memory_order_release);
+    return p;
+  }
+};
+
+// 场景返回总操作数 延迟样本写进logs
+using logs_type = std::vector<latency_log>;
+
+template <typename Backend>
+double size_class_case(size_t size, size_t scale, logs_type &logs) {
+  const size_t batch = 1024;
+  size_t rounds = 200 * scale;
+  logs.resize(1);
+  std::vector<void *> ptrs(batch);
+  for (size_t r = 0; r < rounds; r++) {
+    for (size_t i = 0; i < batch; i++) {
+      ptrs[i] = timed_allocate<Backend>(logs[0], size);
+      *static_cast<char *>(ptrs[i]) = char(i);
+    }
+    for (size_t i = batch; i > 0; i--)
+      Backend::deallocate(ptrs[i - 1], size);
+  }
+  return 2.0 * rounds * batch;
+}
+
+template <typename Backend>
+double cross_thread_case(size_t scale, logs_type &logs) {
+  const size_t pairs = 2;
+  const size_t items = (size_t(1) << 18) * scale;
+  static const size_t sizes[] = {16, 24, 32, 48, 64, 96, 128, 256};
+  std::vector<spsc_queue> queues(pairs);
+  logs.resize(pairs);
+  std::vector<std::thread> threads;
+  for (size_t t = 0; t < pairs; t++) {
+    threads.emplace_back([&, t] {
+      for (size_t i = 0; i < items; i++) {
+        void *p = timed_allocate<Backend>(logs[t], sizes[i % 8]);
+        *static_cast<size_t *>(p) = i;
+        while (!queues[t].push(p))
+          std::this_thread::yield();
+      }
+    });
+    threads.emplace_back([&, t] {
+      for (size_t i = 0; i < items; i++) {
+        void *p;
+        while ((p = queues[t].pop()) == nullptr)
+          std::this_thread::yield();
+        Backend::deallocate(p, sizes[*static_cast<size_t *>(p) % 8]);
+      }
+    });
+  }
+  for (auto &t : threads)
+    t.join();
+  return 2.0 * pairs * items;
+}
+
+// 大小分布偏向小对象 偶尔有超过MAX_BYTES的大对象
+inline size_t churn_size(rng &r) {
+  unsigned long long x = r.next();
+  unsigned int bucket = x % 100;
+  x >>= 8;
+  if (bucket < 80)
+    return 8 + x % 120;
+  if (bucket < 95)
+    return 128 + x % 896;
+  if (bucket < 99)
+    return 1024 + x % 3072;
+  return 4096 + x % 61440;
+}
+
+template <typename Backend>
+double churn_case(size_t nthreads, size_t scale, logs_type &logs) {
+  const size_t slots = 4096;
+  const size_t steps = (size_t(1) << 20) * scale;
+  logs.resize(nthreads);
+  std::vector<std::thread> threads;
+  for (size_t t = 0; t < nthreads; t++) {
+    threads.emplace_back([&, t] {
+      rng r(t + 1);
+      std::vector<void *> ptrs(slots, nullptr);
+      std::vector<size_t> lens(slots, 0);
+      for (size_t i = 0; i < steps; i++) {
+        size_t k = r.next() % slots;
+        if (ptrs[k] != nullptr)
+          Backend::deallocate(ptrs[k], lens[k]);
+        lens[k] = churn_size(r);
+        ptrs[k] = timed_allocate<Backend>(logs[t], lens[k]);
+        *static_cast<char *>(ptrs[k]) = char(i);
+      }
+      for (size_t k = 0; k < slots; k++)
+        if (ptrs[k] != nullptr)
+          Backend::deallocate(ptrs[k], lens[k]);
+    });
+  }
+  for (auto &t : threads)
+    t.join();
+  return 2.0 * nthreads * steps;
+}
+
+// 容器场景记录的是每次插入的耗时 其中包含了容器自己的工作
+template <typename Backend>
+double m_vector_case(size_t scale, logs_type &logs) {
+  const size_t count = 1 << 16;
+  size_t rounds = 40 * scale;
+  logs.resize(1);
+  for (size_t r = 0; r < rounds; r++) {
+    m_vector<long, Backend> v;
+    for (size_t i = 0; i < count; i++) {
+      if (!logs[0].want()) {
+        v.push_back(long(i));
+        continue;
+      }
+      auto begin = clock_type::now();
+      v.push_back(long(i));
+      logs[0].add(begin);
+    }
+  }
+  return double(rounds) * count;
+}
+
+template <typename Backend>
+double std_map_case(size_t scale, logs_type &logs) {
+  using alloc = typename Backend::template std_allocator<std::pair<const int, long>>;
+  const size_t count = 1 << 16;
+  size_t rounds = 10 * scale;
+  logs.resize(1);
+  rng r(7);
+  for (size_t round = 0; round < rounds; round++) {
+    std::map<int, long, std::less<int>, alloc> m;
+    for (size_t i = 0; i < count; i++) {
+      int key = int(r.next() >> 33);
+      if (!logs[0].want()) {
+        m.emplace(key, long(i));
+        continue;
+      }
+      auto begin = clock_type::now();
+      m.emplace(key, long(i));
+      logs[0].add(begin);
+    }
+  }
+  return double(rounds) * count;
+}
+
+template <typename Backend>
+double std_list_case(size_t scale, logs_type &logs) {
+  using alloc = typename Backend::template std_allocator<long>;
+  const size_t count = 1 << 12;
+  size_t rounds = 200 * scale;
+  logs.resize(1);
+  std::list<long, alloc> l;
+  for (size_t round = 0; round < rounds; round++) {
+    for (size_t i = 0; i < count; i++) {
+      if (!logs[0].want()) {
+        round % 2 ? l.push_front(long(i)) : l.push_back(long(i));
+        continue;
+      }
+      auto begin = clock_type::now();
+      round % 2 ? l.push_front(long(i)) : l.push_back(long(i));
+      logs[0].add(begin);
+    }
+    for (size_t i = 0; i < count; i++)
+      round % 3 ? l.pop_front() : l.pop_back();
+  }
+  return 2.0 * rounds * count;
+}
+
+// 读/proc/self/status里的一项 单位kB 其他系统上返回0
+size_t proc_status_kb(const char *key) {
+  std::ifstream in("/proc/self/status");
+  std::string line;
+  size_t len = std::strlen(key);
+  while (std::getline(in, line))
+    if (line.compare(0, len, key) == 0)
+      return std::strtoul(line.c_str() + len, nullptr, 10);
+  return 0;
+}
+
+// 向clear_refs写5会把VmHWM重置为当前RSS 这样子进程的峰值不带父进程的历史
+void reset_peak_rss() {
+  std::ofstream out("/proc/self/clear_refs");
+  out << "5";
+}
+
+bench_result run_case(const std::function<double(logs_type &)> &body) {
+  reset_peak_rss();
+  size_t base_kb = proc_status_kb("VmRSS:");
+  logs_type logs;
+  logs.reserve(64);
+  auto begin = clock_type::now();
+  double ops = body(logs);
+  auto end = clock_type::now();
+
+  bench_result result;
+  result.ops = ops;
+  result.seconds = std::chrono::duration<double>(end - begin).count();
+  size_t peak_kb = proc_status_kb("VmHWM:");
+  result.peak_rss_mb = peak_kb > base_kb ? (peak_kb - base_kb) / 1024.0 : 0;
+
+  std::vector<unsigned int> all;
+  for (auto &log : logs)
+    all.insert(all.end(), log.samples.begin(), log.samples.end());
+  result.p50_ns = result.p99_ns = 0;
+  if (!all.empty()) {
+    size_t p50 = all.size() / 2;
+    size_t p99 = all.size() * 99 / 100;
+    std::nth_element(all.begin(), all.begin() + p50, all.end());
+    result.p50_ns = all[p50];
+    std::nth_element(all.begin(), all.begin() + p99, all.end());
+    result.p99_ns = all[p99];
+  }
+  return result;
+}
+
+// 在子进程里跑一个场景 不支持fork的系统上直接在本进程里跑
+bench_result run_isolated(const std::function<double(logs_type &)> &body) {
+#if defined(__unix__)
+  int fds[2];
+  if (pipe(fds) == 0) {
+    std::cout.flush();
+    pid_t pid = fork();
+    if (pid == 0) {
+      close(fds[0]);
+      bench_result result = run_case(body);
+      ssize_t written = write(fds[1], &result, sizeof(result));
+      _exit(written == ssize_t(sizeof(result)) ? 0 : 1);
+    }
+    close(fds[1]);
+    bench_result result{};
+    bool ok = pid > 0 && read(fds[0], &result, sizeof(result)) ==
+                             ssize_t(sizeof(result));
+    close(fds[0]);
+    if (pid > 0)
+      waitpid(pid, nullptr, 0);
+    if (ok)
+      return result;
+  }
+#endif // defined(__unix__)
+  return run_case(body);
+}
+
+void print_row(const std::string &name, const char *backend,
+               const bench_result &r) {
+  std::printf("%-16s %-7s %10.2f %9.0f %9.0f %10.2f\n", name.c_str(),
+              backend, r.ops / r.seconds / 1e6, r.p50_ns, r.p99_ns,
+              r.peak_rss_mb);
+}
+
+// 同一个场景先跑内存池再跑malloc
+template <template <typename> class Case>
+void run_pair(const std::string &name, const std::string &filter) {
+  if (name.compare(0, filter.size(), filter) != 0)
+    return;
+  print_row(name, pool_backend::name(), run_isolated(Case<pool_backend>()));
+  print_row(name, malloc_backend::name(),
+            run_isolated(Case<malloc_backend>()));
+}
+
+size_t bench_scale = 1;
+size_t case_size = 0;    // size_class场景的对象大小
+size_t case_threads = 0; // churn场景的线程数
+
+template <typename Backend> struct size_class_bench {
+  double operator()(logs_type &logs) const {
+    return size_class_case<Backend>(case_size, bench_scale, logs);
+  }
+};
+template <typename Backend> struct cross_thread_bench {
+  double operator()(logs_type &logs) const {
+    return cross_thread_case<Backend>(bench_scale, logs);
+  }
+};
+template <typename Backend> struct churn_bench {
+  double operator()(logs_type &logs) const {
+    return churn_case<Backend>(case_threads, bench_scale, logs);
+  }
+};
+template <typename Backend> struct m_vector_bench {
+  double operator()(logs_type &logs) const {
+    return m_vector_case<Backend>(bench_scale, logs);
+  }
+};
+template <typename Backend> struct std_map_bench {
+  double operator()(logs_type &logs) const {
+    return std_map_case<Backend>(bench_scale, logs);
+  }
+};
+template <typename Backend> struct std_list_bench {
+  double operator()(logs_type &logs) const {
+    return std_list_case<Backend>(bench_scale, logs);
+  }
+};
+
+} // namespace
+
+int main(int argc, char *argv[]) {
+  std::string filter;
+  if (argc > 1)
+    filter = argv[1];
+  if (argc > 2)
+    bench_scale = std::max<size_t>(1, std::strtoul(argv[2], nullptr, 10));
+
+  my_malloc_allocator::initializer();
+  std::printf("%-16s %-7s %10s %9s %9s %10s\n", "case", "backend", "Mops/s",
+              "p50(ns)", "p99(ns)", "peak_MB");
+
+  for (size_t i = 0; i < size_class_table::CLASS_COUNT; i++) {
+    case_size = size_classes.size[i];
+    run_pair<size_class_bench>("size_class/" + std::to_string(case_size),
+                               filter);
+  }
+  run_pair<cross_thread_bench>("cross_thread", filter);
+  for (size_t threads : {1, 4}) {
+    case_threads = threads;
+    run_pair<churn_bench>("churn/" + std::to_string(threads), filter);
+  }
+  run_pair<m_vector_bench>("m_vector", filter);
+  run_pair<std_map_bench>("std_map", filter);
+  run_pair<std_list_bench>("std_list", filter);
+  return 0;
+}
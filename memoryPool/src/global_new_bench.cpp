@@ -0,0 +1,96 @@
+#include "../../my_B+Tree/include/my_B+Tree.h"
+#include "../../my_RB_tree/include/my_RB_tree.h"
+#include "../../my_vector/include/my_vector.h"
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <map>
+#include <string>
+#include <vector>
+
+// 各个容器测试里的插入操作 分别在系统operator new和内存池替换的operator new下跑
+// global_new_bench使用系统的new global_new_bench_pool链接了memory_pool_new
+// 用法: ./global_new_bench [元素个数] [轮数]
+
+static long sink = 0;
+
+template <typename F> static double measure(F &&f) {
+  auto begin = std::chrono::steady_clock::now();
+  f();
+  auto end = std::chrono::steady_clock::now();
+  return std::chrono::duration<double, std::milli>(end - begin).count();
+}
+
+static void report(const std::string &name, double ms, size_t count,
+                   int rounds) {
+  std::cout << name << "\t" << ms << " ms\t" << ms * 1e6 / (count * rounds)
+            << " ns/op" << std::endl;
+}
+
+// 简单的线性同余序列 每轮插入同样的乱序键
+static int next_key(unsigned &seed) {
+  seed = seed * 1103515245u + 12345u;
+  return int(seed >> 1);
+}
+
+int main(int argc, char *argv[]) {
+  size_t count = 100000;
+  int rounds = 5;
+  if (argc > 1)
+    count = std::strtoul(argv[1], nullptr, 10);
+  if (argc > 2)
+    rounds = std::atoi(argv[2]);
+
+#if defined(POOL_GLOBAL_NEW)
+  std::cout << "operator new: memory pool" << std::endl;
+#else
+  std::cout << "operator new: system" << std::endl;
+#endif // defined(POOL_GLOBAL_NEW)
+
+  // 节点用new 键和子节点指针存在std::vector里
+  report("BPlusTree", measure([&] {
+           for (int r = 0; r < rounds; r++) {
+             BPlusTree<int, 100> tree;
+             for (size_t i = 0; i < count; i++)
+               tree.insert(int(i));
+           }
+         }),
+         count, rounds);
+
+  // 节点和控制块由std::make_shared申请
+  // 节点之间的parent指针构成环 树析构后节点不会释放 每轮都是新申请
+  report("BRTree", measure([&] {
+           unsigned seed = 1;
+           for (int r = 0; r < rounds; r++) {
+             BRTree<int> tree;
+             for (size_t i = 0; i < count; i++)
+               tree.insert(next_key(seed));
+           }
+         }),
+         count, rounds);
+
+  // 存储直接用my_malloc_allocator 元素std::string的内容走operator new
+  report("m_vector", measure([&] {
+           for (int r = 0; r < rounds; r++) {
+             m_vector<std::string> v;
+             for (size_t i = 0; i < count; i++)
+               v.push_back(std::string(24, char('a' + i % 26)));
+             sink += v.size();
+           }
+         }),
+         count, rounds);
+
+  report("std::map<int,std::string>", measure([&] {
+           unsigned seed = 1;
+           for (int r = 0; r < rounds; r++) {
+             std::map<int, std::string> m;
+             for (size_t i = 0; i < count; i++)
+               m.emplace(next_key(seed), std::string(24, 'x'));
+             sink += m.size();
+           }
+         }),
+         count, rounds);
+
+  std::cout << "checksum: " << sink << std::endl;
+  return 0;
+}
@@ -1,144 +1,1385 @@
 #include "../include/memoryPool.h"
+#include <chrono>
+#include <climits>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <thread>
+
+#if defined(_WIN32) || defined(_WIN64)
+#include <malloc.h>
+#else
+#include <sys/mman.h>
+#endif // defined(_WIN32) || defined(_WIN64)
+
+// 大对象向系统申请内存 alignment为0表示不需要额外对齐 失败返回nullptr
+// 替换了全局operator new时改用malloc 否则会递归回内存池
+namespace {
+void *system_allocate(size_t n, size_t alignment) {
+#if defined(POOL_GLOBAL_NEW)
+  void *p;
+#if defined(_WIN32) || defined(_WIN64)
+  p = _aligned_malloc(n, alignment < sizeof(void *) ? sizeof(void *)
+                                                    : alignment);
+#else
+  if (alignment == 0)
+    p = std::malloc(n);
+  else if (posix_memalign(&p, alignment < sizeof(void *) ? sizeof(void *)
+                                                         : alignment,
+                          n) != 0)
+    p = nullptr;
+#endif // defined(_WIN32) || defined(_WIN64)
+  return p;
+#else
+  if (alignment == 0)
+    return operator new(n, std::nothrow);
+  return operator new(n, std::align_val_t(alignment), std::nothrow);
+#endif // defined(POOL_GLOBAL_NEW)
+}
+
+#if BIG_MMAP_ON
+// 直接映射的大对象 长度按页取整
+size_t map_length(size_t bytes) {
+  size_t page = get_page_size();
+  return (bytes + page - 1) & ~(page - 1);
+}
+
+void *system_map(size_t bytes) {
+  void *p = mmap(nullptr, map_length(bytes), PROT_READ | PROT_WRITE,
+                 MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+  return p == MAP_FAILED ? nullptr : p;
+}
+
+void system_unmap(void *p, size_t bytes) { munmap(p, map_length(bytes)); }
+#endif // BIG_MMAP_ON
+
+void system_free(void *p, size_t alignment) {
+#if defined(POOL_GLOBAL_NEW)
+  (void)alignment;
+#if defined(_WIN32) || defined(_WIN64)
+  _aligned_free(p);
+#else
+  std::free(p);
+#endif // defined(_WIN32) || defined(_WIN64)
+#else
+  if (alignment == 0)
+    operator delete(p);
+  else
+    operator delete(p, std::align_val_t(alignment));
+#endif // defined(POOL_GLOBAL_NEW)
+}
+} // namespace
+
+#if NUMA_ON
+#include <sys/syscall.h>
+#endif // NUMA_ON
+
+// 调试模式下用AddressSanitizer编译时 把红区和已释放的对象标记成不可访问
+#if defined(__SANITIZE_ADDRESS__)
+#define POOL_ASAN
+#elif defined(__has_feature)
+#if __has_feature(address_sanitizer)
+#define POOL_ASAN
+#endif // __has_feature(address_sanitizer)
+#endif // defined(__SANITIZE_ADDRESS__)
+
+#if DEBUG_ON && defined(POOL_ASAN)
+#include <sanitizer/asan_interface.h>
+#define POOL_POISON(p, n) ASAN_POISON_MEMORY_REGION((p), (n))
+#define POOL_UNPOISON(p, n) ASAN_UNPOISON_MEMORY_REGION((p), (n))
+#else
+#define POOL_POISON(p, n)
+#define POOL_UNPOISON(p, n)
+#endif // DEBUG_ON && defined(POOL_ASAN)
 #define DOUBLE_ALLOC_ON true
 #if DOUBLE_ALLOC_ON
 size_t my_malloc_allocator::heap_size;
+std::atomic<size_t> my_malloc_allocator::system_bytes;
+std::atomic<size_t> my_malloc_allocator::limit_bytes;
+std::atomic<my_malloc_allocator::custom_alloc_false_func>
+    my_malloc_allocator::alloc_false_handler;
 size_t my_malloc_allocator::page_size;
 
 char *my_malloc_allocator::memoryPoolPtr = nullptr;
 
-char *my_malloc_allocator::start_free;
-char *my_malloc_allocator::end_free;
+char *my_malloc_allocator::start_free[NUMA_NODES][CHUNK_LISTS];
+char *my_malloc_allocator::end_free[NUMA_NODES][CHUNK_LISTS];
+
+#if PAGEMAP_ON
+std::atomic<unsigned char *>
+    my_malloc_allocator::pagemap_root[1 << PAGEMAP_ROOT_BITS];
+#endif // PAGEMAP_ON
+
+my_malloc_allocator::span *my_malloc_allocator::span_list = nullptr;
+size_t my_malloc_allocator::free_bytes = 0;
+size_t my_malloc_allocator::trim_mark = 0;
+my_malloc_allocator::trim_policy my_malloc_allocator::trim_setting = {};
+bool my_malloc_allocator::trim_thread_running = false;
+
+#if STATS_ON
+my_malloc_allocator::stat_counter
+    my_malloc_allocator::class_carved[FREELIST_SIZE];
+my_malloc_allocator::stat_counter my_malloc_allocator::class_free[FREELIST_SIZE];
+my_malloc_allocator::stat_counter
+    my_malloc_allocator::class_refills[FREELIST_SIZE];
+my_malloc_allocator::stat_counter
+    my_malloc_allocator::class_chunk_allocs[FREELIST_SIZE];
+my_malloc_allocator::stat_counter my_malloc_allocator::big_allocs;
+my_malloc_allocator::stat_counter my_malloc_allocator::big_frees;
+my_malloc_allocator::stat_counter my_malloc_allocator::big_live_bytes;
+#endif // STATS_ON
+
+#if DEBUG_ON
+my_malloc_allocator::stat_counter
+    my_malloc_allocator::debug_live[FREELIST_SIZE + 1];
+my_malloc_allocator::stat_counter
+    my_malloc_allocator::debug_live_bytes[FREELIST_SIZE + 1];
+
+// 程序退出时输出泄漏报告 std::cerr由前面包含的iostream保证还能用
+// 在这个对象之后构造的静态对象已经析构 它们释放的内存不算泄漏
+namespace {
+struct leak_reporter {
+  ~leak_reporter() { my_malloc_allocator::report_leaks(std::cerr); }
+} leak_reporter_instance;
+} // namespace
+#endif // DEBUG_ON
+
+#if THREAD_CACHE_ON
+my_malloc_allocator::thread_cache *my_malloc_allocator::caches = nullptr;
+#endif // THREAD_CACHE_ON
 
-#if defined(THREAD_ON) && defined(_PTHREAD_H)
+#if ARENA_ON
+char *my_malloc_allocator::arena_cur = nullptr;
+char *my_malloc_allocator::arena_end = nullptr;
+my_malloc_allocator::span *my_malloc_allocator::free_spans = nullptr;
+#endif // ARENA_ON
+
+#if defined(THREAD_ON)
 
 pthread_mutex_t my_malloc_allocator::mtx = PTHREAD_MUTEX_INITIALIZER;
-#endif // defined(THREAD_ON) && defined(_PTHREAD_H)
+#endif // defined(THREAD_ON)
 
+#if LOCK_FREE_ON
+std::atomic<my_malloc_allocator::tagged_ptr>
+    my_malloc_allocator::free_list[NUMA_NODES][FREELIST_SIZE];
+#else
 volatile typename my_malloc_allocator::obj
-    *my_malloc_allocator::free_list[FREELIST_SIZE] = {};
-#endif // DOUBLE_ALLOC_ON 
+    *my_malloc_allocator::free_list[NUMA_NODES][FREELIST_SIZE] = {};
+#endif // LOCK_FREE_ON
+#endif // DOUBLE_ALLOC_ON
 
 void my_malloc_allocator::initializer() {
   if (memoryPoolPtr)
     return;
 #if DOUBLE_ALLOC_ON
   page_size = get_page_size();
-  memoryPoolPtr = static_cast<char *>(operator new(page_size));
-  start_free = memoryPoolPtr;
-  end_free = start_free + page_size;
-  heap_size = page_size;
+  size_t node = current_node();
+  LOCK(&mtx);
+  // 打开POOL_PAGEMAP时第一个span给类别0
+  if (start_free[node][0] == end_free[node][0]) {
+    memoryPoolPtr = (char *)span_alloc(node, 0);
+    if (memoryPoolPtr == nullptr) {
+      UNLOCK(&mtx);
+      throw std::bad_alloc();
+    }
+    start_free[node][0] = memoryPoolPtr + SPAN_HEADER;
+    end_free[node][0] = memoryPoolPtr + SPAN_BYTES;
+  }
+  UNLOCK(&mtx);
 #endif // DOUBLE_ALLOC_ON
 }
 
 void *my_malloc_allocator::allocate(size_t n) {
+#if DEBUG_ON
+  return debug_allocate(n, ALIGN);
+#else
+  return pool_allocate(n, ALIGN);
+#endif // DEBUG_ON
+}
+
+void *my_malloc_allocator::allocate(size_t n, size_t alignment) {
+  if (alignment < ALIGN)
+    alignment = ALIGN;
+#if DEBUG_ON
+  return debug_allocate(n, alignment);
+#else
+  return pool_allocate(n, alignment);
+#endif // DEBUG_ON
+}
+
+void my_malloc_allocator::deallocate(void *p, size_t size) {
+#if DEBUG_ON
+  debug_deallocate(p, size, ALIGN);
+#else
+  pool_deallocate(p, size, ALIGN);
+#endif // DEBUG_ON
+}
+
+void my_malloc_allocator::deallocate(void *p, size_t size, size_t alignment) {
+  if (alignment < ALIGN)
+    alignment = ALIGN;
+#if DEBUG_ON
+  debug_deallocate(p, size, alignment);
+#else
+  pool_deallocate(p, size, alignment);
+#endif // DEBUG_ON
+}
+
+void my_malloc_allocator::allocate_batch(size_t n, size_t count, void **out) {
+  size_t got = 0;
+#if DOUBLE_ALLOC_ON && !DEBUG_ON
+  if (n <= MAX_BYTES) {
+    for (;;) {
+      got += small_allocate_batch(n, count - got, out + got);
+      if (got == count)
+        return;
+      try {
+        alloc_failed();
+      } catch (...) {
+        small_deallocate_batch(n, got, out);
+        throw;
+      }
+    }
+  }
+#endif // DOUBLE_ALLOC_ON && !DEBUG_ON
+  // 大对象和调试模式下每个对象都要单独处理 逐个申请
+  try {
+    for (; got < count; got++)
+      out[got] = allocate(n);
+  } catch (...) {
+    deallocate_batch(n, got, out);
+    throw;
+  }
+}
+
+void my_malloc_allocator::deallocate_batch(size_t n, size_t count,
+                                           void *const *ptrs) {
+#if DOUBLE_ALLOC_ON && !DEBUG_ON
+  if (n <= MAX_BYTES) {
+    small_deallocate_batch(n, count, ptrs);
+    return;
+  }
+#endif // DOUBLE_ALLOC_ON && !DEBUG_ON
+  for (size_t i = 0; i < count; i++)
+    deallocate(ptrs[i], n);
+}
+
 #if DOUBLE_ALLOC_ON
-  if (n > MAX_BYTES)
-    return big_mem_allocate(n);
-  else
-    return small_mem_allocator::small_mem_allocate(n);
+size_t my_malloc_allocator::small_allocate_batch(size_t n, size_t count,
+                                                 void **out) {
+  size_t index = FREELIST_INDEX(n);
+  n = size_classes.size[index];
+  size_t got = 0;
+#if THREAD_CACHE_ON
+  thread_cache *cache = local_cache();
+  size_t node = cache != nullptr ? cache->node : current_node();
+  if (cache != nullptr) { // 先把本线程缓存里的拿走
+    obj *p = cache->list[index];
+    while (got < count && p != nullptr) {
+      out[got++] = p;
+      p = p->free_list_link;
+    }
+    cache->list[index] = p;
+    cache->set(index, cache->get(index) - (unsigned int)got);
+    if (got == count)
+      return got;
+  }
+#else
+  size_t node = current_node();
+#endif // THREAD_CACHE_ON
+
+  LIST_LOCK(&mtx);
+  got += list_pop_batch(node, index, out + got, count - got);
+  if (got < count) { // 全局链表不够 剩下的从chunk连续切出来
+    STAT_ADD(class_refills[index], 1);
+    CHUNK_LOCK(&mtx);
+    while (got < count) {
+      size_t want = count - got;
+      int nobj = want > size_t(INT_MAX) ? INT_MAX : int(want);
+      char *chunk = chunk_alloc(node, n, nobj);
+      if (chunk == nullptr)
+        break;
+      for (int i = 0; i < nobj; i++)
+        out[got++] = chunk + i * n;
+    }
+    CHUNK_UNLOCK(&mtx);
+  }
+  LIST_UNLOCK(&mtx);
+  return got;
+}
+
+void my_malloc_allocator::small_deallocate_batch(size_t n, size_t count,
+                                                 void *const *ptrs) {
+  size_t index = FREELIST_INDEX(n);
+#if THREAD_CACHE_ON
+  thread_cache *cache = local_cache();
+#endif // THREAD_CACHE_ON
+  // 属于同一节点的连续一段先在锁外连好 节点变了或者结束时整段挂回去
+  obj *first = nullptr;
+  obj *last = nullptr;
+  unsigned int run = 0;
+  size_t run_node = 0;
+  auto flush = [&] {
+    if (run == 0)
+      return;
+    LIST_LOCK(&mtx);
+    // 只有一个节点时直接写0 run_node经过循环之后编译器看不出它的范围
+    // 无锁模式下会报free_list下标越界的警告
+    list_push(NUMA_ON ? run_node : 0, index, first, last, run);
+#if !LOCK_FREE_ON
+    maybe_trim();
+#endif // !LOCK_FREE_ON
+    LIST_UNLOCK(&mtx);
+    run = 0;
+  };
+  for (size_t i = 0; i < count; i++) {
+    obj *p = (obj *)ptrs[i];
+    if (p == nullptr)
+      continue;
+    size_t node = node_of(p);
+#if THREAD_CACHE_ON
+    if (cache != nullptr && node == cache->node) {
+      p->free_list_link = cache->list[index];
+      cache->list[index] = p;
+      cache->set(index, cache->get(index) + 1);
+      continue;
+    }
+#endif // THREAD_CACHE_ON
+    if (run != 0 && node != run_node)
+      flush();
+    if (run == 0) {
+      first = p;
+      run_node = node;
+    } else {
+      last->free_list_link = p;
+    }
+    last = p;
+    run++;
+  }
+  flush();
+#if THREAD_CACHE_ON
+  // 和逐个释放一样 缓存超过两批时只留下一批
+  if (cache != nullptr && cache->get(index) > 2 * batch_count(index))
+    cache_release(*cache, index, cache->get(index) - batch_count(index));
+#endif // THREAD_CACHE_ON
+}
+#endif // DOUBLE_ALLOC_ON
+
+// alignment不超过ALIGN时按n找类别 否则找自然对齐足够的类别
+// 拿不到内存时各条路径都先放掉锁再返回nullptr 在这里调用处理函数后重试
+void *my_malloc_allocator::pool_allocate(size_t n, size_t alignment) {
+  for (;;) {
+    void *p;
+#if DOUBLE_ALLOC_ON
+    if (n <= MAX_BYTES && alignment <= size_class_table::MAX_ALIGN)
+      p = small_mem_allocator::small_mem_allocate(
+          alignment > ALIGN ? size_classes.size[ALIGNED_INDEX(n, alignment)]
+                            : n);
+    else
 #endif // DOUBLE_ALLOC_ON
-  return big_mem_allocate(n);
+      p = alignment <= ALIGN ? big_mem_allocate(n)
+                             : big_mem_allocate(n, alignment);
+    if (p != nullptr)
+      return p;
+    alloc_failed();
+  }
 }
 
-void my_malloc_allocator::deallocate(void *p, size_t size) {
+void my_malloc_allocator::alloc_failed() {
+  custom_alloc_false_func handler = alloc_false_handler.load();
+  if (handler == nullptr)
+    throw std::bad_alloc();
+  handler();
+}
+
+my_malloc_allocator::custom_alloc_false_func
+my_malloc_allocator::set_alloc_false_handler(custom_alloc_false_func func) {
+  return alloc_false_handler.exchange(func);
+}
+
+void my_malloc_allocator::set_memory_limit(size_t bytes) {
+  limit_bytes.store(bytes);
+}
+
+size_t my_malloc_allocator::get_memory_limit() { return limit_bytes.load(); }
+
+void my_malloc_allocator::pool_deallocate(void *p, size_t size,
+                                          size_t alignment) {
   if (p == nullptr)
     return;
 #if DOUBLE_ALLOC_ON
-  size = ROUND_UP(size);
-  if (size <= MAX_BYTES) {
-    LOCK(&my_malloc_allocator::mtx);
-    volatile obj *my_free_list = free_list[FREELIST_INDEX(size)];
-    ((obj *)p)->free_list_link = (obj *)my_free_list;
-    my_free_list = (obj *)p;
-    UNLOCK(&my_malloc_allocator::mtx);
-    p = nullptr;
+  if (size <= MAX_BYTES && alignment <= size_class_table::MAX_ALIGN) {
+    if (alignment > ALIGN)
+      size = size_classes.size[ALIGNED_INDEX(size, alignment)];
+#if THREAD_CACHE_ON
+    // 先还给本线程的缓存 缓存过长的时候整段还给全局链表
+    size_t index = FREELIST_INDEX(size);
+    thread_cache *cache = local_cache();
+    // 缓存已经析构 或者对象属于别的NUMA节点 直接还给所属节点的全局链表
+    size_t node = node_of(p);
+    if (cache == nullptr || node != cache->node) {
+      LIST_LOCK(&my_malloc_allocator::mtx);
+      list_push(node, index, (obj *)p, (obj *)p, 1);
+#if !LOCK_FREE_ON
+      maybe_trim();
+#endif // !LOCK_FREE_ON
+      LIST_UNLOCK(&my_malloc_allocator::mtx);
+      return;
+    }
+    ((obj *)p)->free_list_link = cache->list[index];
+    cache->list[index] = (obj *)p;
+    cache->set(index, cache->get(index) + 1);
+    if (cache->get(index) > 2 * batch_count(index))
+      cache_release(*cache, index, batch_count(index));
+#else
+    LIST_LOCK(&my_malloc_allocator::mtx);
+    list_push(node_of(p), FREELIST_INDEX(size), (obj *)p, (obj *)p, 1);
+#if !LOCK_FREE_ON
+    maybe_trim();
+#endif // !LOCK_FREE_ON
+    LIST_UNLOCK(&my_malloc_allocator::mtx);
+#endif // THREAD_CACHE_ON
+    return;
+  }
+#endif // DOUBLE_ALLOC_ON
+  STAT_ADD(big_frees, 1);
+  STAT_ADD(big_live_bytes, -size);
+  release_bytes(size + big_head(alignment));
+  char *base = (char *)p - big_head(alignment);
+#if BIG_MMAP_ON
+  if (big_mapped(size, alignment)) {
+    // 调试模式下整块内存还标记着不可访问 munmap之后这段地址会被新的映射复用
+    // 不清掉的话ASan会把新span或者新大对象上的读写当成访问已释放的内存
+    POOL_UNPOISON(base, size + big_head(alignment));
+    system_unmap(base, size + big_head(alignment));
     return;
   }
+#endif // BIG_MMAP_ON
+  system_free(base, alignment <= ALIGN ? 0 : alignment);
+}
+
+bool my_malloc_allocator::try_expand(void *p, size_t old_size,
+                                     size_t new_size) {
+  if (p == nullptr || old_size == new_size)
+    return p != nullptr;
+#if DEBUG_ON
+  // 调试模式下对象后面紧跟着红区 大小变了红区也要跟着移动
+  return false;
+#else
+#if DOUBLE_ALLOC_ON
+  // 小对象的实际大小是类别的大小 同一个类别里可以直接使用
+  if (old_size <= MAX_BYTES || new_size <= MAX_BYTES)
+    return old_size <= MAX_BYTES && new_size <= MAX_BYTES &&
+           FREELIST_INDEX(old_size) == FREELIST_INDEX(new_size);
 #endif // DOUBLE_ALLOC_ON
-  operator delete(p);
-  p = nullptr;
-  return;
+#if BIG_MMAP_ON
+  if (big_mapped(old_size, ALIGN) && big_mapped(new_size, ALIGN))
+    return big_remap(p, old_size, new_size, false) != nullptr;
+#endif // BIG_MMAP_ON
+  return false;
+#endif // DEBUG_ON
+}
+
+void *my_malloc_allocator::reallocate(void *p, size_t old_size,
+                                      size_t new_size) {
+  if (p == nullptr)
+    return allocate(new_size);
+  if (try_expand(p, old_size, new_size))
+    return p;
+#if BIG_MMAP_ON && !DEBUG_ON
+  if (big_mapped(old_size, ALIGN) && big_mapped(new_size, ALIGN)) {
+    void *q = big_remap(p, old_size, new_size, true);
+    if (q != nullptr)
+      return q;
+  }
+#endif // BIG_MMAP_ON && !DEBUG_ON
+  // 申请失败时抛出异常 原来的对象不受影响
+  void *q = allocate(new_size);
+  std::memcpy(q, p, old_size < new_size ? old_size : new_size);
+  deallocate(p, old_size);
+  return q;
+}
+
+#if BIG_MMAP_ON
+void *my_malloc_allocator::big_remap(void *p, size_t old_size,
+                                     size_t new_size, bool may_move) {
+  size_t head = big_head(ALIGN);
+  if (new_size > size_t(-1) - head)
+    return nullptr;
+  // 变大时先占用多出来的额度 失败时还回去
+  if (new_size > old_size && !reserve_bytes(new_size - old_size))
+    return nullptr;
+  char *base = (char *)p - head;
+  // 移动之后原来的地址可能被新的映射复用 先清掉ASan的标记
+  POOL_UNPOISON(base, old_size + head);
+  void *moved = mremap(base, map_length(old_size + head),
+                       map_length(new_size + head),
+                       may_move ? MREMAP_MAYMOVE : 0);
+  if (moved == MAP_FAILED) {
+    if (new_size > old_size)
+      release_bytes(new_size - old_size);
+    return nullptr;
+  }
+  if (new_size < old_size)
+    release_bytes(old_size - new_size);
+  STAT_ADD(big_live_bytes, new_size - old_size);
+  char *result = (char *)moved + head;
+#if PAGEMAP_ON
+  ((big_header *)result - 1)->size = new_size;
+#endif // PAGEMAP_ON
+  return result;
+}
+#endif // BIG_MMAP_ON
+
+#if PAGEMAP_ON
+void my_malloc_allocator::deallocate(void *p) {
+  if (p == nullptr)
+    return;
+#if DEBUG_ON
+  // 调试模式下对象前面的头记录了申请时的大小和对齐
+  debug_header *h = debug_header_of(p);
+  POOL_UNPOISON(h, sizeof(debug_header));
+  debug_deallocate(p, h->size, h->alignment);
+#else
+  size_t index = pagemap_class(p);
+  if (index != FREELIST_SIZE)
+    return pool_deallocate(p, size_classes.size[index], ALIGN);
+  big_header *h = (big_header *)p - 1;
+  pool_deallocate(p, h->size, h->alignment);
+#endif // DEBUG_ON
+}
+#endif // PAGEMAP_ON
+
+#if DEBUG_ON
+void *my_malloc_allocator::debug_allocate(size_t n, size_t alignment) {
+  size_t front = debug_front(alignment);
+  size_t bytes = front + n + DEBUG_GUARD;
+  size_t index = FREELIST_SIZE;
+  if (bytes <= MAX_BYTES && alignment <= size_class_table::MAX_ALIGN)
+    index = ALIGNED_INDEX(bytes, alignment);
+  char *block = (char *)pool_allocate(bytes, alignment);
+  // 上一次使用这个块的申请可能更大 整个类别大小都要清掉标记
+  POOL_UNPOISON(block, index == FREELIST_SIZE ? bytes : size_classes.size[index]);
+
+  // 块上一次是按调试模式释放的 检查释放后的填充有没有被改写
+  debug_header *old = debug_freed_header(block);
+  if (index != FREELIST_SIZE && old->state == DEBUG_FREED &&
+      old->alignment <= size_class_table::MAX_ALIGN &&
+      old->size <= MAX_BYTES &&
+      debug_front(old->alignment) + old->size + DEBUG_GUARD <=
+          size_classes.size[index]) {
+    unsigned char *q = (unsigned char *)block + debug_front(old->alignment);
+    for (size_t i = 0; i < old->size; i++)
+      if (q[i] != DEBUG_FREED_BYTE)
+        debug_fail("write after free", q, old->size);
+  }
+
+  char *p = block + front;
+  memset(block + sizeof(obj), DEBUG_GUARD_BYTE, bytes - sizeof(obj));
+  memset(p, DEBUG_NEW_BYTE, n);
+  debug_header *h = debug_header_of(p);
+  h->state = DEBUG_LIVE;
+  h->alignment = (uint32_t)alignment;
+  h->size = n;
+  debug_live[index] += 1;
+  debug_live_bytes[index] += n;
+
+  POOL_POISON(block + sizeof(obj), front - sizeof(obj));
+  POOL_POISON(p + n, DEBUG_GUARD);
+  return p;
+}
+
+void my_malloc_allocator::debug_deallocate(void *p, size_t size,
+                                           size_t alignment) {
+  if (p == nullptr)
+    return;
+  size_t front = debug_front(alignment);
+  size_t bytes = front + size + DEBUG_GUARD;
+  size_t index = FREELIST_SIZE;
+  if (bytes <= MAX_BYTES && alignment <= size_class_table::MAX_ALIGN)
+    index = ALIGNED_INDEX(bytes, alignment);
+  char *block = (char *)p - front;
+  debug_header *h = debug_header_of(p);
+  POOL_UNPOISON(h, sizeof(debug_header));
+
+  if (h->state == DEBUG_FREED)
+    debug_fail("double free", p, size);
+  if (h->state != DEBUG_LIVE)
+    debug_fail("free of a pointer not allocated by the pool", p, size);
+  if (h->size != size || h->alignment != alignment)
+    debug_fail("free with a different size or alignment", p, size);
+
+  POOL_UNPOISON(block + sizeof(obj), bytes - sizeof(obj));
+  unsigned char *q = (unsigned char *)block + sizeof(obj);
+  for (; q != (unsigned char *)p; q++)
+    if ((q < (unsigned char *)h || q >= (unsigned char *)(h + 1)) &&
+        *q != DEBUG_GUARD_BYTE)
+      debug_fail("buffer underflow (front red zone overwritten)", p, size);
+  q = (unsigned char *)p + size;
+  for (size_t i = 0; i < DEBUG_GUARD; i++)
+    if (q[i] != DEBUG_GUARD_BYTE)
+      debug_fail("buffer overflow (back red zone overwritten)", p, size);
+
+  // 对象前面的头只改状态 留着给重复释放报错用
+  memset(p, DEBUG_FREED_BYTE, size);
+  h->state = DEBUG_FREED;
+  debug_header *freed = debug_freed_header(block);
+  freed->state = DEBUG_FREED;
+  freed->alignment = (uint32_t)alignment;
+  freed->size = size;
+  debug_live[index] -= 1;
+  debug_live_bytes[index] -= size;
+
+  POOL_POISON(block + sizeof(obj), bytes - sizeof(obj));
+  pool_deallocate(block, bytes, alignment);
+}
+
+void my_malloc_allocator::debug_fail(const char *what, const void *p,
+                                     size_t size) {
+  std::fprintf(stderr, "memoryPool: %s at %p (%zu bytes)\n", what, p, size);
+  std::abort();
+}
+#endif // DEBUG_ON
+
+size_t my_malloc_allocator::report_leaks(std::ostream &os) {
+#if DEBUG_ON
+  // 对象个数按块所在的类别统计 bytes是使用者申请的字节数 不含红区
+  size_t total = 0;
+  for (size_t i = 0; i <= FREELIST_SIZE; i++) {
+    size_t live = debug_live[i];
+    if (live == 0)
+      continue;
+    if (total == 0)
+      os << "memoryPool leak report\nclass\tsize\tobjects\tbytes\n";
+    if (i == FREELIST_SIZE)
+      os << "big\t-";
+    else
+      os << i << '\t' << size_classes.size[i];
+    os << '\t' << live << '\t' << size_t(debug_live_bytes[i]) << '\n';
+    total += live;
+  }
+  return total;
+#else
+  (void)os;
+  return 0;
+#endif // DEBUG_ON
 }
 
+// 超过上限或者系统内存不足时返回nullptr 由pool_allocate处理
 void *my_malloc_allocator::big_mem_allocate(size_t n) {
-  void *temp = operator new(n);
+  size_t head = big_head(ALIGN);
+  if (n > size_t(-1) - head || !reserve_bytes(n + head))
+    return nullptr;
+  char *temp;
+#if BIG_MMAP_ON
+  if (big_mapped(n, ALIGN))
+    temp = (char *)system_map(n + head);
+  else
+#endif // BIG_MMAP_ON
+    temp = (char *)system_allocate(n + head, 0);
   if (!temp) // 申请失败
   {
-    // alloc_false_func();
+    release_bytes(n + head);
+    return nullptr;
+  }
+  STAT_ADD(big_allocs, 1);
+  STAT_ADD(big_live_bytes, n);
+#if PAGEMAP_ON
+  big_header *h = (big_header *)(temp + head) - 1;
+  h->size = n;
+  h->alignment = ALIGN;
+#endif // PAGEMAP_ON
+  return temp + head;
+}
+
+void *my_malloc_allocator::big_mem_allocate(size_t n, size_t alignment) {
+  size_t head = big_head(alignment);
+  if (n > size_t(-1) - head || !reserve_bytes(n + head))
+    return nullptr;
+  char *temp = (char *)system_allocate(n + head, alignment);
+  if (temp == nullptr) {
+    release_bytes(n + head);
     return nullptr;
   }
-  return temp;
+  STAT_ADD(big_allocs, 1);
+  STAT_ADD(big_live_bytes, n);
+#if PAGEMAP_ON
+  big_header *h = (big_header *)(temp + head) - 1;
+  h->size = n;
+  h->alignment = alignment;
+#endif // PAGEMAP_ON
+  return temp + head;
 }
 
-void *my_malloc_allocator::refill(size_t n) {
-  int nobj = 20;
-  char *chunk = chunk_alloc(n, nobj); // 通过引用nobj返回能够返回的n大小的空间
-  volatile obj **my_free_list = free_list + FREELIST_INDEX(n); // 挂载点
+void my_malloc_allocator::print_size_classes(std::ostream &os) {
+  // worst_waste: 申请上一个类别大小加一字节时浪费的比例
+  // avg_waste: 请求大小在类别区间内均匀分布时平均浪费的比例
+  // tail_waste: 一次切出nobj个对象时凑不满一页剩下的字节
+  // align: 类别的自然对齐 按alignment申请时只会落到align足够的类别
+  os << "class\tsize\talign\tnobj\tchunk\tworst_waste\tavg_waste\t"
+        "tail_waste\n";
+  size_t prev = 0;
+  for (size_t i = 0; i < FREELIST_SIZE; i++) {
+    size_t size = size_classes.size[i];
+    size_t nobj = size_classes.nobj[i];
+    size_t chunk = size * nobj;
+    size_t tail = chunk < size_class_table::REFILL_BYTES
+                      ? size_class_table::REFILL_BYTES - chunk
+                      : 0;
+    double worst = double(size - (prev + 1)) / size;
+    double avg = double(size - prev - 1) / 2 / size;
+    os << i << '\t' << size << '\t' << int(size_classes.align[i]) << '\t'
+       << nobj << '\t' << chunk << '\t'
+       << worst * 100 << "%\t" << avg * 100 << "%\t" << tail << '\n';
+    prev = size;
+  }
+}
+
+void *my_malloc_allocator::refill(size_t node, size_t n) {
+  int nobj = size_classes.nobj[FREELIST_INDEX(n)];
+  STAT_ADD(class_refills[FREELIST_INDEX(n)], 1);
+  char *chunk = chunk_alloc(node, n, nobj); // 通过引用nobj返回能够返回的n大小的空间
+  if (chunk == nullptr)
+    return nullptr;
 
   if (1 == nobj) // 只足够一个n大小的空间
     return chunk;
 
   // 否则说明有多个空间我们需要把整块大小的空间拆开挂在到free_list上面
-
-  // 不进行头插 为了保证以后一个指向null
-  for (int i = 0; i <= nobj - 1; i++) {
+  // 第一个返回给调用者 剩下的连成一段 最后一个指向null
+  for (int i = 1; i < nobj - 1; i++)
     ((obj *)(chunk + i * n))->free_list_link = (obj *)(chunk + (i + 1) * n);
-    if (i == nobj - 1)
-      ((obj *)(chunk + i * n))->free_list_link = NULL;
-  }
-
-  *my_free_list = (obj *)(chunk);
+  ((obj *)(chunk + (nobj - 1) * n))->free_list_link = NULL;
 
-  volatile obj *reuslt = *my_free_list;
-  *my_free_list = (*my_free_list)->free_list_link;
+  list_push(node, FREELIST_INDEX(n), (obj *)(chunk + n),
+            (obj *)(chunk + (nobj - 1) * n), nobj - 1);
 
-  return (void *)reuslt;
-  // 之后从挂载的剩余空间中返回一个空间
+  return (void *)chunk;
 }
 
-char *my_malloc_allocator::chunk_alloc(size_t n, int &nobj) {
+char *my_malloc_allocator::chunk_alloc(size_t node, size_t n, int &nobj) {
   // 这个函数是专门用来返回内存池chunk的
+  // 每个NUMA节点有自己的chunk 下面的start/end就是node节点的start_free/end_free
+  // 打开POOL_PAGEMAP时每个类别各有一个chunk
+  size_t index = FREELIST_INDEX(n);
+  char *&start = start_free[node][chunk_list(index)];
+  char *&end = end_free[node][chunk_list(index)];
 
   char *result;
-  size_t total_bytes = n * nobj;             // 要求的总大小
-  size_t bytes_left = end_free - start_free; // 剩余内存
+  size_t total_bytes = n * nobj;    // 要求的总大小
+  size_t bytes_left = end - start; // 剩余内存
+  // 对象按类别的自然对齐切 start前面对不齐的几个字节当作边角回收
+  size_t pad = (0 - (uintptr_t)start) & (size_classes.align[index] - 1);
 
-  if (bytes_left >= total_bytes) {
-    result = start_free;
-    start_free += total_bytes;
-    return result;
-  } else if (bytes_left >= n) {
-    result = start_free;
-    nobj = bytes_left / n;
-    start_free += n * nobj;
+  if (bytes_left >= pad + n) {
+    chunk_leftover(node, start, pad);
+    start += pad;
+    bytes_left -= pad;
+    result = start;
+    if (bytes_left < total_bytes)
+      nobj = bytes_left / n;
+    start += n * nobj;
+    STAT_ADD(class_chunk_allocs[index], 1);
+    STAT_ADD(class_carved[index], nobj);
     return result;
   } else {
     // 到这里就是chunk中已经不满足要分配的大小了
     // 为了充分利用free_list中挂在的内存我们要对其重新挂在后面的
+    // 打开POOL_PAGEMAP时span只能放一个类别的对象 剩下的边角直接丢掉
+#if !PAGEMAP_ON
+    chunk_leftover(node, start, bytes_left);
+#endif // !PAGEMAP_ON
+    start = end;
+
+    // 每次从系统申请一个新的span
+    char *new_span = (char *)span_alloc(node, index);
+#if !LOCK_FREE_ON
+    // 系统内存不足或者到了上限 先把完全空闲的span还回去腾出额度再试一次
+    // 调用者持有LIST_LOCK 可以直接trim 无锁模式下不能归还span
+    if (new_span == nullptr && trim_locked(0) != 0)
+      new_span = (char *)span_alloc(node, index);
+#endif // !LOCK_FREE_ON
+    if (new_span == nullptr) { // 最新分配内存失败了
+#if !PAGEMAP_ON
+      // 只拿自然对齐不小于当前类别的块 这样切的时候不需要再对齐
+      // 先找本节点的free_list 再找别的节点的
+      for (size_t k = 0; k < NUMA_NODES; k++) {
+        size_t from = (node + k) % NUMA_NODES;
+        for (size_t i = index; i < FREELIST_SIZE; i++) {
+          if (size_classes.align[i] < size_classes.align[index])
+            continue;
+          obj *p = list_pop(from, i);
+          if (p != nullptr) // 有空余的内存这样我们就把它从旧挂载点卸载
+          {
+            STAT_ADD(class_carved[i], -1);
+            POOL_UNPOISON(p, size_classes.size[i]);
+            start = (char *)p;
+            end = start + size_classes.size[i];
+            return chunk_alloc(node, n, nobj);
+          }
+        }
+      }
+#endif // !PAGEMAP_ON
+      // 调用者放掉锁之后由pool_allocate调用处理函数
+      start = end = nullptr;
+      return nullptr;
+    }
+    start = new_span + SPAN_HEADER;
+    end = new_span + SPAN_BYTES;
+    return chunk_alloc(node, n, nobj);
+  }
+}
+
+// 剩下的边角总是8的倍数 按能装下的最大类别切成几块挂到free_list上
+// 这样span里的每个字节最终都会回到某条free_list 整个span才能被trim
+// 挂上去的块也要满足所在类别的自然对齐 对不齐就换更小的类别
+void my_malloc_allocator::chunk_leftover(size_t node, char *p, size_t bytes) {
+  while (bytes > 0) {
+    size_t index =
+        bytes > MAX_BYTES ? FREELIST_SIZE - 1 : FREELIST_FLOOR(bytes);
+    while (((uintptr_t)p & (size_classes.align[index] - 1)) != 0)
+      index--;
+    size_t piece = size_classes.size[index];
+    list_push(node, index, (obj *)p, (obj *)p, 1);
+    STAT_ADD(class_carved[index], 1);
+    p += piece;
+    bytes -= piece;
+  }
+}
+
+#if THREAD_CACHE_ON
+void *my_malloc_allocator::cache_refill(thread_cache &cache, size_t index) {
+  size_t n = size_classes.size[index];
+  int nobj = batch_count(index);
+  obj *chain = nullptr;
+  int got = 0;
+  STAT_ADD(class_refills[index], 1);
+
+  LIST_LOCK(&mtx);
+  // 先把全局链表上现成的节点摘下来
+  obj *p;
+  while (got < nobj && (p = list_pop(cache.node, index)) != nullptr) {
+    p->free_list_link = chain;
+    chain = p;
+    got++;
+  }
+  if (got == 0) { // 全局链表也空了 直接从chunk切一页左右
+    int total = size_classes.nobj[index];
+    CHUNK_LOCK(&mtx);
+    char *chunk = chunk_alloc(cache.node, n, total);
+    CHUNK_UNLOCK(&mtx);
+    if (chunk == nullptr) {
+      LIST_UNLOCK(&mtx);
+      return nullptr;
+    }
+    got = total < nobj ? total : nobj;
+    for (int i = 0; i < total - 1; i++)
+      ((obj *)(chunk + i * n))->free_list_link = (obj *)(chunk + (i + 1) * n);
+    ((obj *)(chunk + (total - 1) * n))->free_list_link = nullptr;
+    // 前got个放进缓存 剩下的挂到全局链表
+    if (total > got) {
+      ((obj *)(chunk + (got - 1) * n))->free_list_link = nullptr;
+      list_push(cache.node, index, (obj *)(chunk + got * n),
+                (obj *)(chunk + (total - 1) * n), total - got);
+    }
+    chain = (obj *)chunk;
+  }
+  LIST_UNLOCK(&mtx);
+
+  cache.list[index] = chain->free_list_link;
+  cache.set(index, got - 1);
+  return (void *)chain;
+}
+
+void my_malloc_allocator::cache_release(thread_cache &cache, size_t index,
+                                        unsigned int nobj) {
+  obj *first = cache.list[index];
+  if (first == nullptr || nobj == 0)
+    return;
+
+  // 在锁外找到要归还的这一段的尾节点
+  obj *last = first;
+  unsigned int moved = 1;
+  while (moved < nobj && last->free_list_link != nullptr) {
+    last = last->free_list_link;
+    moved++;
+  }
+  cache.list[index] = last->free_list_link;
+  cache.set(index, cache.get(index) - moved);
+
+  LIST_LOCK(&mtx);
+  list_push(cache.node, index, first, last, moved);
+#if !LOCK_FREE_ON
+  maybe_trim();
+#endif // !LOCK_FREE_ON
+  LIST_UNLOCK(&mtx);
+}
+
+my_malloc_allocator::thread_cache::thread_cache()
+    : list(), count(), next(nullptr), prev(nullptr), node(current_node()) {
+  LOCK(&mtx);
+  next = caches;
+  if (caches != nullptr)
+    caches->prev = this;
+  caches = this;
+  UNLOCK(&mtx);
+}
+
+my_malloc_allocator::thread_cache::~thread_cache() {
+  // 从这里开始local_cache()返回nullptr 下面归还对象时不会再放回这个缓存
+  cache_destroyed() = true;
+  for (size_t i = 0; i < FREELIST_SIZE; i++) {
+    if (list[i] != nullptr)
+      cache_release(*this, i, get(i));
+  }
+  LOCK(&mtx);
+  if (prev != nullptr)
+    prev->next = next;
+  else
+    caches = next;
+  if (next != nullptr)
+    next->prev = prev;
+  UNLOCK(&mtx);
+}
+#endif // THREAD_CACHE_ON
+
+#if LOCK_FREE_ON
+my_malloc_allocator::obj *my_malloc_allocator::list_pop(size_t node,
+                                                        size_t index) {
+  std::atomic<tagged_ptr> &head = free_list[node][index];
+  tagged_ptr old = head.load(std::memory_order_acquire);
+  while (tag_pointer(old) != nullptr) {
+    // 池里的内存不会还给系统 所以即使这个节点已经被别的线程弹出
+    // 读它的free_list_link也是安全的 版本号不对CAS自然会失败
+    obj *top = tag_pointer(old);
+    obj *link = __atomic_load_n(&top->free_list_link, __ATOMIC_RELAXED);
+    tagged_ptr next = make_tagged(link, old);
+    if (head.compare_exchange_weak(old, next, std::memory_order_acq_rel,
+                                   std::memory_order_acquire)) {
+      STAT_ADD(class_free[index], -1);
+      return top;
+    }
+  }
+  return nullptr;
+}
+
+void my_malloc_allocator::list_push(size_t node, size_t index, obj *first,
+                                    obj *last, unsigned int nobj) {
+  std::atomic<tagged_ptr> &head = free_list[node][index];
+  tagged_ptr old = head.load(std::memory_order_relaxed);
+  do {
+    last->free_list_link = tag_pointer(old);
+  } while (!head.compare_exchange_weak(old, make_tagged(first, old),
+                                       std::memory_order_release,
+                                       std::memory_order_relaxed));
+  STAT_ADD(class_free[index], nobj);
+  (void)nobj;
+}
+
+// 无锁栈一次摘下一整段会有ABA问题 逐个弹出
+size_t my_malloc_allocator::list_pop_batch(size_t node, size_t index,
+                                           void **out, size_t count) {
+  size_t got = 0;
+  obj *p;
+  while (got < count && (p = list_pop(node, index)) != nullptr)
+    out[got++] = p;
+  return got;
+}
+#else
+my_malloc_allocator::obj *my_malloc_allocator::list_pop(size_t node,
+                                                        size_t index) {
+  volatile obj **my_free_list = free_list[node] + index;
+  obj *result = (obj *)*my_free_list;
+  if (result != nullptr) {
+    *my_free_list = result->free_list_link;
+    free_bytes -= size_classes.size[index];
+    STAT_ADD(class_free[index], -1);
+  }
+  return result;
+}
 
-    if (bytes_left > 0) {
-      volatile obj **my_free_list = free_list + FREELIST_INDEX(bytes_left);
-      ((obj *)(start_free))->free_list_link = (obj *)*my_free_list;
-      (*my_free_list)->free_list_link = (obj *)(start_free);
+void my_malloc_allocator::list_push(size_t node, size_t index, obj *first,
+                                    obj *last, unsigned int nobj) {
+  volatile obj **my_free_list = free_list[node] + index;
+  last->free_list_link = (obj *)*my_free_list;
+  *my_free_list = first;
+  free_bytes += nobj * size_classes.size[index];
+  STAT_ADD(class_free[index], nobj);
+}
+
+// 沿着链表走count步 再把表头一次改到剩下的部分
+size_t my_malloc_allocator::list_pop_batch(size_t node, size_t index,
+                                           void **out, size_t count) {
+  volatile obj **my_free_list = free_list[node] + index;
+  obj *p = (obj *)*my_free_list;
+  size_t got = 0;
+  while (got < count && p != nullptr) {
+    out[got++] = p;
+    p = p->free_list_link;
+  }
+  *my_free_list = p;
+  free_bytes -= got * size_classes.size[index];
+  STAT_ADD(class_free[index], -(long)got);
+  return got;
+}
+#endif // LOCK_FREE_ON
+
+my_malloc_allocator::span *my_malloc_allocator::span_alloc(size_t node,
+                                                          size_t index) {
+  static_assert(sizeof(span) <= SPAN_HEADER, "span header does not fit");
+  // 先占用额度 超过上限时不向系统申请 后面映射失败时再还回去
+  if (!reserve_bytes(SPAN_BYTES))
+    return nullptr;
+#if ARENA_ON
+  char *base;
+  if (free_spans != nullptr) { // 优先复用归还过的span
+    base = (char *)free_spans;
+    free_spans = free_spans->next;
+  } else {
+    if (arena_cur == arena_end) {
+      // 多保留一个大页的大小 再把两头没对齐的部分还回去
+      size_t reserve = ARENA_BYTES + HUGE_PAGE_BYTES;
+      char *raw = (char *)mmap(nullptr, reserve, PROT_READ | PROT_WRITE,
+                               MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE,
+                               -1, 0);
+      if (raw == MAP_FAILED) {
+        release_bytes(SPAN_BYTES);
+        return nullptr;
+      }
+      char *aligned =
+          (char *)(((uintptr_t)raw + HUGE_PAGE_BYTES - 1) &
+                   ~(uintptr_t)(HUGE_PAGE_BYTES - 1));
+      if (aligned != raw)
+        munmap(raw, aligned - raw);
+      if (raw + HUGE_PAGE_BYTES != aligned)
+        munmap(aligned + ARENA_BYTES, raw + HUGE_PAGE_BYTES - aligned);
+#if defined(POOL_HUGE_PAGE) && defined(MADV_HUGEPAGE)
+      madvise(aligned, ARENA_BYTES, MADV_HUGEPAGE);
+#endif // defined(POOL_HUGE_PAGE) && defined(MADV_HUGEPAGE)
+      arena_cur = aligned;
+      arena_end = aligned + ARENA_BYTES;
     }
+    base = arena_cur;
+    arena_cur += SPAN_BYTES;
+  }
+#elif defined(_WIN32) || defined(_WIN64)
+  char *base = (char *)_aligned_malloc(SPAN_BYTES, SPAN_BYTES);
+  if (base == nullptr) {
+    release_bytes(SPAN_BYTES);
+    return nullptr;
+  }
+#else
+  // 多映射一个span的大小 再把两头没对齐的部分还回去
+  char *raw = (char *)mmap(nullptr, 2 * SPAN_BYTES, PROT_READ | PROT_WRITE,
+                           MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+  if (raw == MAP_FAILED) {
+    release_bytes(SPAN_BYTES);
+    return nullptr;
+  }
+  char *base = (char *)span_of(raw + SPAN_BYTES - 1);
+  if (base != raw)
+    munmap(raw, base - raw);
+  if (raw + SPAN_BYTES != base)
+    munmap(base + SPAN_BYTES, raw + SPAN_BYTES - base);
+#endif // defined(_WIN32) || defined(_WIN64)
+
+#if NUMA_ON
+  // 在第一次写之前把整个span绑定到node节点 失败时退回first-touch
+  // MPOL_PREFERRED 节点内存不够时可以用别的节点 不会因此分配失败
+  const int mpol_preferred = 1;
+  unsigned long mask = 1UL << node;
+  syscall(SYS_mbind, base, (unsigned long)SPAN_BYTES, mpol_preferred, &mask,
+          sizeof(mask) * 8, 0);
+#endif // NUMA_ON
+
+  span *s = (span *)base;
+  s->prev = nullptr;
+  s->next = span_list;
+  s->free_bytes = 0;
+  s->node = node;
+  s->cls = index;
+  s->release = false;
+  if (span_list != nullptr)
+    span_list->prev = s;
+  span_list = s;
+  heap_size += SPAN_BYTES;
+#if PAGEMAP_ON
+  // 基数树的叶子申请失败时这个span不能用
+  if (!pagemap_set(s, (unsigned char)(index + 1))) {
+    span_free(s);
+    return nullptr;
+  }
+#else
+  (void)index;
+#endif // PAGEMAP_ON
+  return s;
+}
+
+#if PAGEMAP_ON
+bool my_malloc_allocator::pagemap_set(span *s, unsigned char value) {
+  uintptr_t key = (uintptr_t)s >> SPAN_SHIFT;
+  uintptr_t root = key >> PAGEMAP_LEAF_BITS;
+  if (root >= (uintptr_t(1) << PAGEMAP_ROOT_BITS))
+    return false;
+  unsigned char *leaf = pagemap_root[root].load(std::memory_order_relaxed);
+  if (leaf == nullptr) {
+    if (value == 0)
+      return true;
+    leaf = (unsigned char *)std::calloc(size_t(1) << PAGEMAP_LEAF_BITS, 1);
+    if (leaf == nullptr)
+      return false;
+    pagemap_root[root].store(leaf, std::memory_order_release);
+  }
+  leaf[key & ((uintptr_t(1) << PAGEMAP_LEAF_BITS) - 1)] = value;
+  return true;
+}
+#endif // PAGEMAP_ON
+
+void my_malloc_allocator::span_free(span *s) {
+  if (s->prev != nullptr)
+    s->prev->next = s->next;
+  else
+    span_list = s->next;
+  if (s->next != nullptr)
+    s->next->prev = s->prev;
+  if ((char *)s == memoryPoolPtr)
+    memoryPoolPtr = nullptr;
+  heap_size -= SPAN_BYTES;
+  release_bytes(SPAN_BYTES);
+#if PAGEMAP_ON
+  pagemap_set(s, 0);
+#endif // PAGEMAP_ON
+  // 调试模式下span里已释放的对象还标记着不可访问 归还之前清掉
+  POOL_UNPOISON(s, SPAN_BYTES);
+
+#if ARENA_ON
+  // 保留span头所在的页用来挂到free_spans上 其余的页还给系统
+  size_t page = get_page_size();
+  madvise((char *)s + page, SPAN_BYTES - page, MADV_DONTNEED);
+  s->next = free_spans;
+  free_spans = s;
+#elif defined(_WIN32) || defined(_WIN64)
+  _aligned_free(s);
+#else
+  munmap(s, SPAN_BYTES);
+#endif // ARENA_ON
+}
+
+size_t my_malloc_allocator::trim(size_t keep_bytes) {
+#if LOCK_FREE_ON
+  // 无锁栈弹出时可能读到别的线程刚弹出的节点 内存必须一直可读 所以不归还
+  (void)keep_bytes;
+  return 0;
+#else
+  LOCK(&mtx);
+  size_t released = trim_locked(keep_bytes);
+  UNLOCK(&mtx);
+  return released;
+#endif // LOCK_FREE_ON
+}
 
-    size_t bytes_to_get = total_bytes * 2 + (heap_size >> 4);
-    start_free = static_cast<char *>(operator new(bytes_to_get));
-    if (0 == start_free) { // 最新分配内存失败了
+size_t my_malloc_allocator::trim_locked(size_t keep_bytes) {
+#if LOCK_FREE_ON
+  (void)keep_bytes;
+  return 0;
+#else
+  // 第一遍 统计每个span挂在free_list上的字节数
+  for (span *s = span_list; s != nullptr; s = s->next) {
+    s->free_bytes = 0;
+    s->release = false;
+  }
+  for (size_t node = 0; node < NUMA_NODES; node++)
+    for (size_t i = 0; i < FREELIST_SIZE; i++)
+      for (obj *p = (obj *)free_list[node][i]; p != nullptr;
+           p = p->free_list_link)
+        span_of(p)->free_bytes += size_classes.size[i];
+
+  // 正在切的span还有一段没挂到free_list上 自然不会被认为是空闲的
+  size_t kept = 0;
+  bool any = false;
+  for (span *s = span_list; s != nullptr; s = s->next) {
+    if (s->free_bytes != span_capacity(s))
+      continue;
+    if (kept < keep_bytes)
+      kept += SPAN_BYTES;
+    else
+      s->release = any = true;
+  }
+  if (!any)
+    return 0;
 
-      for (int i = n; i <= MAX_BYTES; i += ALIGN) {
-        volatile obj **my_free_list = free_list + FREELIST_INDEX(n);
-        if (my_free_list != 0) // 有空余的内存这样我们就把它从旧挂载点卸载
-        {
-          start_free = (char *)*my_free_list;
-          end_free = start_free + i;
-          (*my_free_list) = (*my_free_list)->free_list_link;
-          return chunk_alloc(n, nobj);
+  // 第二遍 把要归还的span里的节点从free_list上摘掉
+  for (size_t node = 0; node < NUMA_NODES; node++) {
+    for (size_t i = 0; i < FREELIST_SIZE; i++) {
+      obj *prev = nullptr;
+      obj *p = (obj *)free_list[node][i];
+      while (p != nullptr) {
+        obj *next = p->free_list_link;
+        if (span_of(p)->release) {
+          if (prev == nullptr)
+            free_list[node][i] = next;
+          else
+            prev->free_list_link = next;
+          free_bytes -= size_classes.size[i];
+          STAT_ADD(class_free[i], -1);
+          STAT_ADD(class_carved[i], -1);
+        } else {
+          prev = p;
         }
+        p = next;
       }
     }
-    end_free = start_free + bytes_to_get;
-    heap_size += bytes_to_get;
-    return chunk_alloc(n, nobj);
   }
-}
\ No newline at end of file
+
+  size_t released = 0;
+  span *s = span_list;
+  while (s != nullptr) {
+    span *next = s->next;
+    if (s->release) {
+      span_free(s);
+      released += SPAN_BYTES;
+    }
+    s = next;
+  }
+  return released;
+#endif // LOCK_FREE_ON
+}
+
+void my_malloc_allocator::set_trim_policy(const trim_policy &policy) {
+  LOCK(&mtx);
+  trim_setting = policy;
+  trim_mark = free_bytes + policy.free_threshold;
+  bool start = policy.interval_ms != 0 && !trim_thread_running;
+  if (start)
+    trim_thread_running = true;
+  UNLOCK(&mtx);
+
+#if defined(THREAD_ON) && !LOCK_FREE_ON
+  if (!start)
+    return;
+  // 后台线程每次醒来重新读取策略 interval_ms被设成0就退出
+  std::thread([] {
+    for (;;) {
+      LOCK(&mtx);
+      unsigned int interval = trim_setting.interval_ms;
+      size_t keep = trim_setting.keep_bytes;
+      if (interval == 0)
+        trim_thread_running = false;
+      UNLOCK(&mtx);
+      if (interval == 0)
+        return;
+      std::this_thread::sleep_for(std::chrono::milliseconds(interval));
+      trim(keep);
+    }
+  }).detach();
+#endif // defined(THREAD_ON) && !LOCK_FREE_ON
+}
+
+void my_malloc_allocator::get_stats(pool_stats &stats) {
+  stats = pool_stats();
+  LOCK(&mtx);
+  stats.enabled = STATS_ON;
+  stats.heap_bytes = heap_size;
+  stats.spans = heap_size / SPAN_BYTES;
+  stats.system_bytes = system_bytes.load(std::memory_order_relaxed);
+  stats.limit_bytes = limit_bytes.load(std::memory_order_relaxed);
+#if STATS_ON
+  stats.big_allocs = big_allocs;
+  stats.big_frees = big_frees;
+  stats.big_live_bytes = big_live_bytes;
+  for (size_t i = 0; i < FREELIST_SIZE; i++) {
+    class_stats &c = stats.classes[i];
+    c.size = size_classes.size[i];
+    c.refills = class_refills[i];
+    c.chunk_allocs = class_chunk_allocs[i];
+#if THREAD_CACHE_ON
+    for (thread_cache *t = caches; t != nullptr; t = t->next)
+      c.cached_objects += t->get(i);
+#endif // THREAD_CACHE_ON
+    size_t carved = class_carved[i];
+    c.free_objects = class_free[i] + c.cached_objects;
+    // 无锁模式下计数不在同一把锁里更新 可能短暂地出现free比carved大
+    c.live_objects = carved > c.free_objects ? carved - c.free_objects : 0;
+    c.reserved_bytes = carved * c.size;
+    c.used_bytes = c.live_objects * c.size;
+  }
+#else
+  for (size_t i = 0; i < FREELIST_SIZE; i++)
+    stats.classes[i].size = size_classes.size[i];
+#endif // STATS_ON
+  UNLOCK(&mtx);
+}
+
+void my_malloc_allocator::dump_stats(std::ostream &os) {
+  pool_stats stats;
+  get_stats(stats);
+  os << "{\"enabled\":" << (stats.enabled ? "true" : "false")
+     << ",\"heap_bytes\":" << stats.heap_bytes << ",\"spans\":" << stats.spans
+     << ",\"system_bytes\":" << stats.system_bytes
+     << ",\"limit_bytes\":" << stats.limit_bytes
+     << ",\"big\":{\"allocs\":" << stats.big_allocs
+     << ",\"frees\":" << stats.big_frees
+     << ",\"live_bytes\":" << stats.big_live_bytes << "},\"classes\":[";
+  for (size_t i = 0; i < FREELIST_SIZE; i++) {
+    const class_stats &c = stats.classes[i];
+    os << (i == 0 ? "" : ",") << "{\"class\":" << i << ",\"size\":" << c.size
+       << ",\"live\":" << c.live_objects << ",\"free\":" << c.free_objects
+       << ",\"cached\":" << c.cached_objects << ",\"refills\":" << c.refills
+       << ",\"chunk_allocs\":" << c.chunk_allocs
+       << ",\"reserved_bytes\":" << c.reserved_bytes
+       << ",\"used_bytes\":" << c.used_bytes << "}";
+  }
+  os << "]}\n";
+}
+
+int my_malloc_allocator::numa_node_count() {
+#if NUMA_ON
+  // possible的内容形如"0"或者"0-3"
+  static int count = [] {
+    int first = 0, last = 0;
+    FILE *f = std::fopen("/sys/devices/system/node/possible", "r");
+    if (f != nullptr) {
+      if (std::fscanf(f, "%d-%d", &first, &last) < 2)
+        last = first;
+      std::fclose(f);
+    }
+    return last + 1;
+  }();
+  return count;
+#else
+  return 1;
+#endif // NUMA_ON
+}
+
+size_t my_malloc_allocator::detect_node() {
+#if NUMA_ON
+  unsigned int cpu = 0, node = 0;
+  if (syscall(SYS_getcpu, &cpu, &node, nullptr) != 0)
+    return 0;
+  return node % NUMA_NODES;
+#else
+  return 0;
+#endif // NUMA_ON
+}
+
+int my_malloc_allocator::thread_node() { return (int)current_node(); }
+
+void my_malloc_allocator::set_thread_node(int node) {
+#if NUMA_ON
+  size_t target = size_t(node) % NUMA_NODES;
+#if THREAD_CACHE_ON
+  // 缓存里的对象属于原来的节点 切换之前全部还回去
+  thread_cache *cache = local_cache();
+  if (cache != nullptr && cache->node != target) {
+    for (size_t i = 0; i < FREELIST_SIZE; i++)
+      if (cache->list[i] != nullptr)
+        cache_release(*cache, i, cache->get(i));
+    cache->node = target;
+  }
+#endif // THREAD_CACHE_ON
+  thread_node_slot() = target;
+#else
+  (void)node;
+#endif // NUMA_ON
+}
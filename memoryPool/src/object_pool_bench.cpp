@@ -0,0 +1,107 @@
+#include "../include/object_pool.h"
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+
+// 链表节点的构造和整体销毁 对比new/delete 内存池和object_pool
+// 用法: ./object_pool_bench [节点个数] [轮数]
+
+struct node {
+  node *next;
+  long value;
+};
+
+static long sink = 0;
+
+template <typename F> static double measure(F &&f) {
+  auto begin = std::chrono::steady_clock::now();
+  f();
+  auto end = std::chrono::steady_clock::now();
+  return std::chrono::duration<double, std::milli>(end - begin).count();
+}
+
+// 建一条count个节点的链表 遍历一次之后逐个释放
+template <typename Alloc, typename Free>
+static void build_and_free(size_t count, Alloc alloc, Free free) {
+  node *head = nullptr;
+  for (size_t i = 0; i < count; i++) {
+    node *p = alloc();
+    p->next = head;
+    p->value = long(i);
+    head = p;
+  }
+  for (node *p = head; p != nullptr; p = p->next)
+    sink += p->value;
+  while (head != nullptr) {
+    node *next = head->next;
+    free(head);
+    head = next;
+  }
+}
+
+static void report(const std::string &name, double ms, size_t count,
+                   int rounds) {
+  std::cout << name << "\t" << ms << " ms\t" << ms * 1e6 / (count * rounds)
+            << " ns/node" << std::endl;
+}
+
+int main(int argc, char *argv[]) {
+  size_t count = 1000000;
+  int rounds = 5;
+  if (argc > 1)
+    count = std::strtoul(argv[1], nullptr, 10);
+  if (argc > 2)
+    rounds = std::atoi(argv[2]);
+
+  my_malloc_allocator::initializer();
+  std::cout << "slot bytes: " << object_pool<node>::slot_bytes()
+            << "  slots per slab: " << object_pool<node>::slots_per_slab()
+            << std::endl;
+
+  report("new/delete", measure([&] {
+           for (int r = 0; r < rounds; r++)
+             build_and_free(
+                 count, [] { return new node; }, [](node *p) { delete p; });
+         }),
+         count, rounds);
+
+  report("memory pool", measure([&] {
+           for (int r = 0; r < rounds; r++)
+             build_and_free(
+                 count,
+                 [] {
+                   return (node *)my_malloc_allocator::allocate(sizeof(node));
+                 },
+                 [](node *p) {
+                   my_malloc_allocator::deallocate(p, sizeof(node));
+                 });
+         }),
+         count, rounds);
+
+  report("object_pool", measure([&] {
+           object_pool<node> pool;
+           for (int r = 0; r < rounds; r++)
+             build_and_free(
+                 count, [&] { return pool.allocate(); },
+                 [&](node *p) { pool.deallocate(p); });
+         }),
+         count, rounds);
+
+  // 不逐个释放 整体归还
+  report("destroy_all", measure([&] {
+           for (int r = 0; r < rounds; r++) {
+             object_pool<node> pool;
+             node *head = nullptr;
+             for (size_t i = 0; i < count; i++)
+               head = pool.create(node{head, long(i)});
+             for (node *p = head; p != nullptr; p = p->next)
+               sink += p->value;
+             pool.destroy_all();
+           }
+         }),
+         count, rounds);
+
+  std::cout << "checksum: " << sink << std::endl;
+  return 0;
+}
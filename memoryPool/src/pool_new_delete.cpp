@@ -0,0 +1,104 @@
+#include "../include/memoryPool.h"
+#include <new>
+
+// 用内存池替换全局的operator new/delete
+// 链接了这个文件的程序里所有的new都走内存池 包括std::shared_ptr的控制块
+// 和std::vector的存储 memoryPool.cpp要用POOL_GLOBAL_NEW编译
+// CMake里链接memory_pool_new目标就会同时加上这个文件和宏
+#if !defined(POOL_GLOBAL_NEW)
+#error "pool_new_delete.cpp needs memoryPool.cpp built with POOL_GLOBAL_NEW"
+#endif // !defined(POOL_GLOBAL_NEW)
+
+namespace {
+// 申请失败时和标准库一样反复调用new_handler 没有设置时抛出bad_alloc
+void *pool_new(std::size_t n, std::size_t alignment) {
+  for (;;) {
+    try {
+      return my_malloc_allocator::allocate(n, alignment);
+    } catch (const std::bad_alloc &) {
+      std::new_handler handler = std::get_new_handler();
+      if (handler == nullptr)
+        throw;
+      handler();
+    }
+  }
+}
+
+void *pool_new_nothrow(std::size_t n, std::size_t alignment) noexcept {
+  try {
+    return pool_new(n, alignment);
+  } catch (...) {
+    return nullptr;
+  }
+}
+} // namespace
+
+void *operator new(std::size_t n) { return pool_new(n, 0); }
+void *operator new[](std::size_t n) { return pool_new(n, 0); }
+
+void *operator new(std::size_t n, const std::nothrow_t &) noexcept {
+  return pool_new_nothrow(n, 0);
+}
+void *operator new[](std::size_t n, const std::nothrow_t &) noexcept {
+  return pool_new_nothrow(n, 0);
+}
+
+void *operator new(std::size_t n, std::align_val_t al) {
+  return pool_new(n, std::size_t(al));
+}
+void *operator new[](std::size_t n, std::align_val_t al) {
+  return pool_new(n, std::size_t(al));
+}
+
+void *operator new(std::size_t n, std::align_val_t al,
+                   const std::nothrow_t &) noexcept {
+  return pool_new_nothrow(n, std::size_t(al));
+}
+void *operator new[](std::size_t n, std::align_val_t al,
+                     const std::nothrow_t &) noexcept {
+  return pool_new_nothrow(n, std::size_t(al));
+}
+
+// 不带大小的delete通过基数树找到对象的类别
+void operator delete(void *p) noexcept { my_malloc_allocator::deallocate(p); }
+void operator delete[](void *p) noexcept {
+  my_malloc_allocator::deallocate(p);
+}
+
+void operator delete(void *p, const std::nothrow_t &) noexcept {
+  my_malloc_allocator::deallocate(p);
+}
+void operator delete[](void *p, const std::nothrow_t &) noexcept {
+  my_malloc_allocator::deallocate(p);
+}
+
+// 带大小的delete直接按大小找类别 不查基数树
+void operator delete(void *p, std::size_t n) noexcept {
+  my_malloc_allocator::deallocate(p, n);
+}
+void operator delete[](void *p, std::size_t n) noexcept {
+  my_malloc_allocator::deallocate(p, n);
+}
+
+void operator delete(void *p, std::align_val_t) noexcept {
+  my_malloc_allocator::deallocate(p);
+}
+void operator delete[](void *p, std::align_val_t) noexcept {
+  my_malloc_allocator::deallocate(p);
+}
+
+void operator delete(void *p, std::align_val_t,
+                     const std::nothrow_t &) noexcept {
+  my_malloc_allocator::deallocate(p);
+}
+void operator delete[](void *p, std::align_val_t,
+                       const std::nothrow_t &) noexcept {
+  my_malloc_allocator::deallocate(p);
+}
+
+void operator delete(void *p, std::size_t n, std::align_val_t al) noexcept {
+  my_malloc_allocator::deallocate(p, n, std::size_t(al));
+}
+void operator delete[](void *p, std::size_t n, std::align_val_t al) noexcept {
+  my_malloc_allocator::deallocate(p, n, std::size_t(al));
+}
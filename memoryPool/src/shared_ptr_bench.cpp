@@ -0,0 +1,95 @@
+#include "../include/local_shared_ptr.h"
+#include "../include/memoryPool.h"
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+
+// 智能指针创建 拷贝 销毁的耗时对比
+// std::make_shared          对象和控制块在一次全局new里
+// pool + deleter            以前的make_shared_with_pool 对象在池里 控制块单独new
+// make_shared_with_pool     对象和控制块在一次内存池申请里
+// make_local_shared_with_pool 同上 引用计数不是原子的
+// 用法: ./shared_ptr_bench [对象个数] [轮数]
+
+struct payload {
+  long id;
+  double values[3];
+  explicit payload(long id) : id(id), values{1.0, 2.0, 3.0} {}
+};
+
+static long sink = 0;
+
+// 每一轮先创建count个对象 每个拷贝一次 再全部销毁
+template <typename Ptr, typename Make>
+static double run(size_t count, int rounds, Make make) {
+  std::vector<Ptr> ptrs;
+  ptrs.reserve(count * 2);
+  auto begin = std::chrono::steady_clock::now();
+  for (int r = 0; r < rounds; r++) {
+    for (size_t i = 0; i < count; i++)
+      ptrs.push_back(make(long(i)));
+    for (size_t i = 0; i < count; i++)
+      ptrs.push_back(ptrs[i]);
+    for (size_t i = 0; i < ptrs.size(); i++)
+      sink += ptrs[i]->id;
+    ptrs.clear();
+  }
+  auto end = std::chrono::steady_clock::now();
+  return std::chrono::duration<double, std::nano>(end - begin).count() /
+         (double(count) * rounds);
+}
+
+int main(int argc, char *argv[]) {
+  size_t count = 100000;
+  int rounds = 20;
+  if (argc > 1)
+    count = std::strtoul(argv[1], nullptr, 10);
+  if (argc > 2)
+    rounds = std::atoi(argv[2]);
+
+  my_malloc_allocator::initializer();
+  std::cout << "ns per object (create + copy + destroy)" << std::endl;
+
+  std::cout << "std::make_shared\t"
+            << run<std::shared_ptr<payload>>(
+                   count, rounds,
+                   [](long id) { return std::make_shared<payload>(id); })
+            << std::endl;
+
+  std::cout << "pool + deleter\t\t"
+            << run<std::shared_ptr<payload>>(
+                   count, rounds,
+                   [](long id) {
+                     payload *p = (payload *)my_malloc_allocator::allocate(
+                         sizeof(payload));
+                     new (p) payload(id);
+                     return std::shared_ptr<payload>(p, [](payload *ptr) {
+                       ptr->~payload();
+                       my_malloc_allocator::deallocate(ptr, sizeof(payload));
+                     });
+                   })
+            << std::endl;
+
+  std::cout << "make_shared_with_pool\t"
+            << run<std::shared_ptr<payload>>(
+                   count, rounds,
+                   [](long id) {
+                     return my_malloc_allocator::make_shared_with_pool<payload>(
+                         id);
+                   })
+            << std::endl;
+
+  std::cout << "make_local_shared\t"
+            << run<local_shared_ptr<payload>>(
+                   count, rounds,
+                   [](long id) {
+                     return make_local_shared_with_pool<payload>(id);
+                   })
+            << std::endl;
+
+  std::cout << "checksum: " << sink << std::endl;
+  return 0;
+}
@@ -0,0 +1,7 @@
+#include "../include/memoryPool.h"
+#include <iostream>
+
+int main() {
+  my_malloc_allocator::print_size_classes(std::cout);
+  return 0;
+}
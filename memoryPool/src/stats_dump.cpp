@@ -0,0 +1,21 @@
+#include "../include/memoryPool.h"
+#include <iostream>
+#include <vector>
+
+// 申请一些大小不同的对象之后输出统计快照
+int main() {
+  std::vector<void *> small;
+  for (size_t i = 0; i < 1000; i++)
+    small.push_back(my_malloc_allocator::allocate(8 + i % 200));
+  void *big = my_malloc_allocator::allocate(10000);
+
+  for (size_t i = 0; i < small.size(); i += 2)
+    my_malloc_allocator::deallocate(small[i], 8 + i % 200);
+
+  my_malloc_allocator::dump_stats(std::cout);
+
+  for (size_t i = 1; i < small.size(); i += 2)
+    my_malloc_allocator::deallocate(small[i], 8 + i % 200);
+  my_malloc_allocator::deallocate(big, 10000);
+  return 0;
+}
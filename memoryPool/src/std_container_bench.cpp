@@ -0,0 +1,122 @@
+#include "../include/pool_allocator.h"
+#include "../include/pool_resource.h"
+#include <chrono>
+#include <cstdlib>
+#include <functional>
+#include <iostream>
+#include <list>
+#include <map>
+#include <memory_resource>
+#include <random>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// 比较标准容器分别使用std::allocator和pool_allocator时的耗时
+// 以及pmr容器使用new_delete_resource pool_resource和单调资源时的耗时
+// 用法: ./std_container_bench [元素个数]
+
+template <typename F> static double measure(F &&f) {
+  auto begin = std::chrono::steady_clock::now();
+  f();
+  auto end = std::chrono::steady_clock::now();
+  return std::chrono::duration<double, std::milli>(end - begin).count();
+}
+
+static void report(const std::string &name, double std_ms, double pool_ms) {
+  std::cout << name << "\tstd: " << std_ms << " ms\tpool: " << pool_ms
+            << " ms\tspeedup: " << std_ms / pool_ms << std::endl;
+}
+
+static long sink = 0;
+
+// 反复构造和清空小vector
+template <typename Alloc> static void vector_workload(size_t n) {
+  for (size_t round = 0; round < n / 64; round++) {
+    std::vector<int, Alloc> v;
+    for (int i = 0; i < 64; i++)
+      v.push_back(i);
+    sink += v.back();
+  }
+}
+
+// 插入之后随机删除一半再全部清空
+template <typename Alloc> static void map_workload(size_t n) {
+  std::map<int, int, std::less<int>, Alloc> m;
+  std::mt19937 rng(1);
+  for (size_t i = 0; i < n; i++)
+    m.emplace(int(rng()), int(i));
+  for (size_t i = 0; i < n / 2; i++)
+    m.erase(int(rng()));
+  sink += long(m.size());
+}
+
+template <typename Alloc> static void unordered_map_workload(size_t n) {
+  std::unordered_map<int, int, std::hash<int>, std::equal_to<int>, Alloc> m;
+  for (size_t i = 0; i < n; i++)
+    m.emplace(int(i * 7), int(i));
+  for (size_t i = 0; i < n; i += 2)
+    m.erase(int(i * 7));
+  sink += long(m.size());
+}
+
+template <typename Alloc> static void list_workload(size_t n) {
+  std::list<int, Alloc> l;
+  for (size_t i = 0; i < n; i++)
+    l.push_back(int(i));
+  while (l.size() > n / 2) {
+    l.pop_front();
+    l.push_back(1);
+    l.pop_back();
+    l.pop_front();
+  }
+  sink += long(l.size());
+}
+
+// pmr容器默认构造时使用get_default_resource() 换掉默认资源就能比较不同的后端
+template <typename F>
+static double measure_with(std::pmr::memory_resource *resource, F &&f) {
+  std::pmr::memory_resource *old = std::pmr::set_default_resource(resource);
+  double ms = measure(f);
+  std::pmr::set_default_resource(old);
+  return ms;
+}
+
+template <typename T, typename F>
+static void report_pmr(const std::string &name, F &&f) {
+  using alloc = std::pmr::polymorphic_allocator<T>;
+  double new_delete_ms =
+      measure_with(std::pmr::new_delete_resource(), [&] { f(alloc()); });
+  double pool_ms = measure_with(pool_resource(), [&] { f(alloc()); });
+  pool_monotonic_resource monotonic;
+  double monotonic_ms = measure_with(&monotonic, [&] { f(alloc()); });
+  std::cout << name << "\tnew_delete: " << new_delete_ms
+            << " ms\tpool: " << pool_ms << " ms\tmonotonic: " << monotonic_ms
+            << " ms" << std::endl;
+}
+
+int main(int argc, char *argv[]) {
+  size_t n = 1000000;
+  if (argc > 1)
+    n = std::strtoul(argv[1], nullptr, 10);
+
+  using map_value = std::pair<const int, int>;
+
+  report("vector", measure([&] { vector_workload<std::allocator<int>>(n); }),
+         measure([&] { vector_workload<pool_allocator<int>>(n); }));
+  report("map", measure([&] { map_workload<std::allocator<map_value>>(n); }),
+         measure([&] { map_workload<pool_allocator<map_value>>(n); }));
+  report("unordered_map",
+         measure([&] { unordered_map_workload<std::allocator<map_value>>(n); }),
+         measure([&] { unordered_map_workload<pool_allocator<map_value>>(n); }));
+  report("list", measure([&] { list_workload<std::allocator<int>>(n); }),
+         measure([&] { list_workload<pool_allocator<int>>(n); }));
+
+
+  report_pmr<map_value>("pmr map",
+                        [&](auto a) { map_workload<decltype(a)>(n); });
+  report_pmr<int>("pmr list", [&](auto a) { list_workload<decltype(a)>(n); });
+
+  std::cout << "checksum: " << sink << std::endl;
+  return 0;
+}
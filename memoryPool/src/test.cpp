@@ -5,4 +5,25 @@ int main() {
   int *p = (int*)my_malloc_allocator::allocate(sizeof(int));
   *p = 1;
   std::cout<<*p;
-}
\ No newline at end of file
+  my_malloc_allocator::deallocate(p, sizeof(int));
+
+  // 释放一个直接映射的大对象之后 新的span和大对象可能拿到同一段地址
+  // main_debug用-fsanitize=address编译时 这里不能报告访问已释放的内存
+  const size_t big = 1 << 20;
+  char *b = (char *)my_malloc_allocator::allocate(big);
+  b[0] = b[big - 1] = 1;
+  my_malloc_allocator::deallocate(b, big);
+  const size_t count = 100000;
+  void **small = (void **)my_malloc_allocator::allocate(count * sizeof(void *));
+  for (size_t i = 0; i < count; i++) {
+    small[i] = my_malloc_allocator::allocate(64);
+    *(char *)small[i] = 1;
+  }
+  b = (char *)my_malloc_allocator::allocate(big);
+  b[0] = b[big - 1] = 1;
+  my_malloc_allocator::deallocate(b, big);
+  for (size_t i = 0; i < count; i++)
+    my_malloc_allocator::deallocate(small[i], 64);
+  my_malloc_allocator::deallocate(small, count * sizeof(void *));
+  std::cout<<std::endl;
+}
@@ -0,0 +1,70 @@
+#include "../include/memoryPool.h"
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <thread>
+#include <vector>
+
+// 多线程小对象分配的吞吐测试 线程数从1增加到N
+// 用法: ./thread_cache_bench [最大线程数] [每个线程的轮数]
+
+static const size_t sizes[] = {8, 16, 24, 32, 48, 64, 96, 128};
+static const size_t sizes_count = sizeof(sizes) / sizeof(sizes[0]);
+
+// 每一轮先连续申请batch个对象再全部释放 模拟链表和树节点的构造和销毁
+static void worker(size_t rounds, size_t batch) {
+  std::vector<void *> ptrs(batch);
+  for (size_t r = 0; r < rounds; r++) {
+    for (size_t i = 0; i < batch; i++) {
+      ptrs[i] = my_malloc_allocator::allocate(sizes[i % sizes_count]);
+      *static_cast<char *>(ptrs[i]) = static_cast<char>(i);
+    }
+    for (size_t i = 0; i < batch; i++)
+      my_malloc_allocator::deallocate(ptrs[i], sizes[i % sizes_count]);
+  }
+}
+
+int main(int argc, char *argv[]) {
+  size_t max_threads = std::thread::hardware_concurrency();
+  if (max_threads < 4)
+    max_threads = 4;
+  size_t rounds = 2000;
+  const size_t batch = 256;
+  if (argc > 1)
+    max_threads = std::strtoul(argv[1], nullptr, 10);
+  if (argc > 2)
+    rounds = std::strtoul(argv[2], nullptr, 10);
+
+  my_malloc_allocator::initializer();
+#if THREAD_CACHE_ON
+  std::cout << "mode: thread cache" << std::endl;
+#elif LOCK_FREE_ON
+  std::cout << "mode: lock-free free list" << std::endl;
+#else
+  std::cout << "mode: global lock" << std::endl;
+#endif // THREAD_CACHE_ON
+#if NUMA_ON
+  std::cout << "numa nodes: " << my_malloc_allocator::numa_node_count()
+            << std::endl;
+#endif // NUMA_ON
+  std::cout << "threads\tMops/s\tspeedup" << std::endl;
+
+  double base = 0;
+  for (size_t n = 1; n <= max_threads; n *= 2) {
+    auto begin = std::chrono::steady_clock::now();
+    std::vector<std::thread> threads;
+    for (size_t i = 0; i < n; i++)
+      threads.emplace_back(worker, rounds, batch);
+    for (auto &t : threads)
+      t.join();
+    auto end = std::chrono::steady_clock::now();
+
+    double seconds = std::chrono::duration<double>(end - begin).count();
+    // 一次申请加一次释放记为两次操作
+    double mops = 2.0 * n * rounds * batch / seconds / 1e6;
+    if (n == 1)
+      base = mops;
+    std::cout << n << '\t' << mops << '\t' << mops / base << std::endl;
+  }
+  return 0;
+}
@@ -0,0 +1,82 @@
+#include "../include/memoryPool.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+// 随机遍历大量节点的测试 模拟树和链表上的指针追逐
+// 节点按随机顺序连成一条链 每走一步基本都落在不同的页上 TLB miss占主要开销
+// 分别用默认的span后端和arena(大页)后端编译 比较每一步的耗时
+// 用法: ./tlb_bench [节点个数] [遍历次数]
+
+struct node {
+  node *next;
+  long payload[5];
+};
+
+// 读取进程使用的透明大页大小 只在linux下有
+static std::string anon_huge_pages() {
+  std::ifstream in("/proc/self/smaps_rollup");
+  std::string line;
+  while (std::getline(in, line))
+    if (line.compare(0, 14, "AnonHugePages:") == 0)
+      return line.substr(14);
+  return " unknown";
+}
+
+int main(int argc, char *argv[]) {
+  size_t count = size_t(1) << 21;
+  int passes = 3;
+  if (argc > 1)
+    count = std::strtoul(argv[1], nullptr, 10);
+  if (argc > 2)
+    passes = std::atoi(argv[2]);
+
+#if ARENA_ON && defined(POOL_HUGE_PAGE)
+  std::cout << "backend: arena + MADV_HUGEPAGE" << std::endl;
+#elif ARENA_ON
+  std::cout << "backend: arena" << std::endl;
+#else
+  std::cout << "backend: span mmap" << std::endl;
+#endif // ARENA_ON
+
+  std::vector<node *> nodes(count);
+  for (size_t i = 0; i < count; i++) {
+    nodes[i] = (node *)my_malloc_allocator::allocate(sizeof(node));
+    nodes[i]->payload[0] = long(i);
+  }
+
+  // 打乱顺序后首尾相连
+  std::vector<node *> order(nodes);
+  std::shuffle(order.begin(), order.end(), std::mt19937_64(2025));
+  for (size_t i = 0; i < count; i++)
+    order[i]->next = order[(i + 1) % count];
+
+  long sum = 0;
+  double best = 0;
+  for (int pass = 0; pass < passes; pass++) {
+    auto begin = std::chrono::steady_clock::now();
+    node *cur = order[0];
+    for (size_t i = 0; i < count; i++) {
+      sum += cur->payload[0];
+      cur = cur->next;
+    }
+    auto end = std::chrono::steady_clock::now();
+    double ns = std::chrono::duration<double, std::nano>(end - begin).count();
+    if (pass == 0 || ns < best)
+      best = ns;
+  }
+
+  std::cout << "nodes: " << count << std::endl;
+  std::cout << "ns/hop: " << best / count << std::endl;
+  std::cout << "AnonHugePages:" << anon_huge_pages() << std::endl;
+  std::cout << "checksum: " << sum << std::endl;
+
+  for (size_t i = 0; i < count; i++)
+    my_malloc_allocator::deallocate(nodes[i], sizeof(node));
+  return 0;
+}
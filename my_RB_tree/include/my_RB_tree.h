@@ -18,7 +18,7 @@ template <typename T> struct RBTreeNode {
 
   valueType data;
 
-  RBTreeNode(valueType val, Color c = Red, pointer l = nullptr,
+  RBTreeNode(const valueType &val, Color c = Red, pointer l = nullptr,
              pointer r = nullptr, pointer p = nullptr)
       : left(l), right(r), parent(p), data(val), color(c) {}
   RBTreeNode(leftValue val, Color c = Red, pointer l = nullptr,
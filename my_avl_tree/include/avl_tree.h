@@ -1,6 +1,10 @@
-#include "memoryPool.h"
+#include "../../memoryPool/include/arena_allocator.h"
+#include "../../memoryPool/include/memoryPool.h"
 #include <algorithm>
+#include <initializer_list>
 #include <iostream>
+#include <iterator>
+#include <type_traits>
 #include <utility>
 #include <new>
 namespace m_stl {
@@ -26,10 +30,39 @@ public:
   using PNode = AVLNode<T> *;
   using Node = AVLNode<T>;
 
-  AVL_Tree() : root(nullptr) {
+  AVL_Tree() : root(nullptr), spare(nullptr) {
     DefualtAllocator::initializer();
     }
 
+  // 批量建树
+  template <typename InputIt,
+            typename = std::enable_if_t<!std::is_integral_v<InputIt>>>
+  AVL_Tree(InputIt first, InputIt last) : AVL_Tree() {
+    insert(first, last);
+  }
+  AVL_Tree(std::initializer_list<T> init) : AVL_Tree(init.begin(), init.end()) {}
+
+  // 节点归这棵树所有 浅拷贝会让两棵树释放同一批节点
+  AVL_Tree(const AVL_Tree &) = delete;
+  AVL_Tree &operator=(const AVL_Tree &) = delete;
+
+  AVL_Tree(AVL_Tree &&other) noexcept : root(other.root), spare(other.spare) {
+    other.root = nullptr;
+    other.spare = nullptr;
+  }
+  AVL_Tree &operator=(AVL_Tree &&other) noexcept {
+    if (this != &other) {
+      destroy_tree();
+      root = other.root;
+      spare = other.spare;
+      other.root = nullptr;
+      other.spare = nullptr;
+    }
+    return *this;
+  }
+
+  ~AVL_Tree() { destroy_tree(); }
+
 public:
   template<typename U>
   void insert(U &&value) {
@@ -37,6 +70,36 @@ public:
     std::cout << "插入 " << value << " 成功" << std::endl;
   }
 
+  // 插入一段值 节点每次用allocate_batch申请一批放在spare上
+  // 重复的值不会用掉节点 剩下的最后一起还给分配器
+  template <typename InputIt,
+            typename = std::enable_if_t<!std::is_integral_v<InputIt>>>
+  void insert(InputIt first, InputIt last) {
+    using category = typename std::iterator_traits<InputIt>::iterator_category;
+    void *nodes[BATCH_NODES];
+    while (first != last) {
+      size_t count = BATCH_NODES;
+      if constexpr (std::is_base_of_v<std::forward_iterator_tag, category>) {
+        size_t left = std::distance(first, last);
+        count = left < count ? left : count;
+      }
+      DefualtAllocator::allocate_batch(sizeof(Node), count, nodes);
+      for (size_t i = count; i > 0; i--) {
+        PNode node = static_cast<PNode>(nodes[i - 1]);
+        node->left = spare;
+        spare = node;
+      }
+      try {
+        for (size_t i = 0; i < count && first != last; i++, ++first)
+          insert(*first);
+      } catch (...) {
+        release_spare();
+        throw;
+      }
+      release_spare();
+    }
+  }
+
   void print() { printHelper(root); }
 
 protected:
@@ -124,18 +187,19 @@ protected:
     if (!node)
       return nullptr;
 
+    updateHeight(node);
     int balance = getBalanceFactor(node);
     int leftBalance = getBalanceFactor(node->left);
     int rightBalance = getBalanceFactor(node->right);
 
     if (balance > 1 && leftBalance >= 0) {
       std::cout << "LL型 右旋" << std::endl;
-      rightRotate(node);
+      return rightRotate(node);
     }
 
     if (balance < -1 && rightBalance <= 0) {
       std::cout << "RR型 左旋" << std::endl;
-      leftRotate(node);
+      return leftRotate(node);
     }
 
     if (balance > 1 && leftBalance < 0) {
@@ -153,14 +217,82 @@ protected:
   }
   template<typename U>
   PNode construct_node(U &&value) {
-    PNode node = static_cast<PNode>
-        (DefualtAllocator::allocate(sizeof(Node)));
-    new (node) Node(nullptr, nullptr, 0, std::forward<U>(value));
+    PNode node;
+    bool from_spare = spare != nullptr;
+    if (from_spare) { // 批量插入时先用预先申请的节点
+      node = spare;
+      spare = spare->left;
+    } else {
+      node = static_cast<PNode>(DefualtAllocator::allocate(sizeof(Node)));
+    }
+    try {
+      new (node) Node(nullptr, nullptr, 0, std::forward<U>(value));
+    } catch (...) {
+      // 构造失败的节点放回spare或者还给分配器
+      if (from_spare) {
+        node->left = spare;
+        spare = node;
+      } else {
+        DefualtAllocator::deallocate(node, sizeof(Node));
+      }
+      throw;
+    }
     //PNode node = new Node(nullptr, nullptr, 0, std::forward<U>(value));
     return node;
   }
 
+  // 攒够一批节点再一起还给分配器
+  enum { BATCH_NODES = 64 };
+  struct node_batch {
+    void *nodes[BATCH_NODES];
+    size_t count = 0;
+
+    void push(PNode node) {
+      nodes[count++] = node;
+      if (count == BATCH_NODES)
+        flush();
+    }
+    void flush() {
+      DefualtAllocator::deallocate_batch(sizeof(Node), count, nodes);
+      count = 0;
+    }
+  };
+
+  // 销毁所有节点 分配器整体释放并且元素不需要析构时 不用遍历整棵树
+  void destroy_tree() {
+    if constexpr (!skip_destroy_v<DefualtAllocator, T>) {
+      node_batch batch;
+      destroy_node(root, batch);
+      batch.flush();
+      release_spare();
+    }
+    root = nullptr;
+    spare = nullptr;
+  }
+
+  // 后序遍历销毁子树
+  void destroy_node(PNode node, node_batch &batch) {
+    if (!node)
+      return;
+    destroy_node(node->left, batch);
+    destroy_node(node->right, batch);
+    node->~Node();
+    batch.push(node);
+  }
+
+  // 把spare上没用到的节点还回去 这些节点没有构造过
+  void release_spare() {
+    node_batch batch;
+    while (spare != nullptr) {
+      PNode next = spare->left;
+      batch.push(spare);
+      spare = next;
+    }
+    batch.flush();
+  }
+
 private:
   PNode root;
+  PNode spare; // 批量插入时预先申请 还没有用到的节点 用left连接
 }; // class AVL_Tree
 } // namespace m_stl
\ No newline at end of file
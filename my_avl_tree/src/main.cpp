@@ -7,4 +7,10 @@ int main() {
     t.insert(i);
   }
   t.print();
+  std::cout << std::endl;
+
+  // 批量建树 节点一次申请一批 重复的4用不到的节点会还回去
+  m_stl::AVL_Tree<int> bulk{4, 2, 6, 1, 3, 5, 7, 4};
+  bulk.print();
+  std::cout << std::endl;
 }
\ No newline at end of file
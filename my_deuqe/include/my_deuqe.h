@@ -1,13 +1,13 @@
 #ifndef MY_DEQUE_H_
 #define MY_DEQUE_H_
 
-#include "memoryPool.h"
+#include "../../memoryPool/include/memoryPool.h"
 #include <cstddef>
 #include <initializer_list>
 
 namespace m_stl {
 
-template <typename T, typename Default_allocator = my_malloc_allocator<0>,
+template <typename T, typename Default_allocator = my_malloc_allocator,
           size_t buffsize = (512 > sizeof(T)) ? 1 : (512 / sizeof(T))>
 class my_deque {
 public:
@@ -3,8 +3,9 @@
 
 #include <glog/logging.h>
 
+#include "../../memoryPool/include/arena_allocator.h"
 #include "./iterator_type.h"
-#include "./memoryPool.h"
+#include "../../memoryPool/include/memoryPool.h"
 
 #include <algorithm>
 #include <cassert>
@@ -14,7 +15,7 @@
 #include <utility>
 
 namespace m_stl {
-template <typename T, typename Default_allocator = my_malloc_allocator<0>>
+template <typename T, typename Default_allocator = my_malloc_allocator>
 class list {
 
 public:
@@ -338,29 +339,19 @@ public:
     head.prev = &head;
   }
   list(std::size_t n, const value_type &value) : head(), allocator(), _size(0) {
-    allocate_and_fill_value(head, n, value);
+    allocate_and_fill_value(n, value);
   }
   // 拷贝构造
   list(list &other) : head(), allocator(), _size(0) {
-    iterator other_it = other.begin();
-    for (int i = 0; i < other._size; i++) {
-      list_node *tmp = construct(*other_it);
-      insert(tmp);
-      other_it++;
-      _size++;
-    }
+    allocate_and_copy(other.begin(), other._size);
   }
   // 初始化列表构造函数
   list(std::initializer_list<T> init) : head(), allocator(), _size(0) {
     // 初始化哨兵节点
     head.next = &head;
     head.prev = &head;
-    // 遍历初始化列表，逐个构造节点并插入
-    for (const T &value : init) {
-      list_node *new_node = construct(value);
-      insert(new_node);
-      _size++;
-    }
+    // 节点按批申请 再用初始化列表里的值逐个构造并插入
+    allocate_and_copy(init.begin(), init.size());
   }
   // 移动拷贝构造
   list(list &&other) : head(), allocator(), _size(other._size) {
@@ -379,11 +370,7 @@ public:
   list &operator=(list &other) {
     if (this != &other) {
       clear();
-      for (iterator it = other.begin(); it != other.end(); ++it) {
-        list_node *new_node = construct(*it); // 通过值构造新节点
-        insert(new_node);
-        _size++;
-      }
+      allocate_and_copy(other.begin(), other._size);
     }
     return *this;
   }
@@ -456,11 +443,19 @@ public:
 
 protected:
   // 申请n个空间并且使用value初始化他们
-  void allocate_and_fill_value(list_head& head, size_t n,
-                               const value_type &value);
+  void allocate_and_fill_value(size_t n, const value_type &value);
+  // 申请n个空间并且依次用first开始的n个值初始化
+  template <typename Iter> void allocate_and_copy(Iter first, size_t n);
+  // 每次用allocate_batch申请一批节点 用construct_at在每个节点上构造后接到尾部
+  // 批量释放时同样攒够一批再调用deallocate_batch
+  enum { BATCH_NODES = 64 };
+  template <typename Construct>
+  void allocate_nodes(size_t n, Construct construct_at);
   list_node *construct(const value_type &value);
   template <typename... Args> list_node *construct_in_place(Args... args);
   void deconstruct(list_node *);
+  // 析构并释放[first, last)的节点 调用之前已经从链表上摘下来 返回节点个数
+  size_t release_nodes(list_node *first, list_node *last);
   void insert(list_node *);
 
 private:
@@ -553,21 +548,57 @@ list<T, Default_allocator>::erase(iterator pos) {
   this->_size--;
   return ret;
 }
+// 整段摘下来之后一起释放
 template <typename T, typename Default_allocator>
 typename list<T, Default_allocator>::iterator
 list<T, Default_allocator>::erase(iterator first, iterator last) {
-  while (first != last) {
-    first = erase(first);
-  }
+  list_node *node = first.now_node;
+  list_node *end = last.now_node;
+  if (node == end)
+    return last;
+  node->prev->next = end;
+  end->prev = node->prev;
+  this->_size -= release_nodes(node, end);
   return last;
 }
 template <typename T, typename Default_allocator>
 void list<T, Default_allocator>::clear() {
-  while (!empty()) {
-    erase(begin());
-  }
+  // 分配器整体释放并且元素不需要析构时 直接丢掉所有节点
+  if constexpr (!skip_destroy_v<Default_allocator, value_type>)
+    release_nodes(head.next, &head);
+  head.next = &head;
+  head.prev = &head;
   this->_size = 0;
 }
+
+template <typename T, typename Default_allocator>
+size_t list<T, Default_allocator>::release_nodes(list_node *first,
+                                                 list_node *last) {
+  size_t released = 0;
+  if constexpr (skip_destroy_v<Default_allocator, value_type>) {
+    for (; first != last; first = first->next)
+      released++;
+  } else {
+    // 先析构元素 可以平凡析构时跳过 节点攒够一批再一起还给分配器
+    void *nodes[BATCH_NODES];
+    size_t count = 0;
+    while (first != last) {
+      list_node *next = first->next;
+      if constexpr (!std::is_trivially_destructible_v<value_type>)
+        first->value.~value_type();
+      nodes[count++] = first;
+      if (count == BATCH_NODES) {
+        allocator.deallocate_batch(sizeof(list_node), count, nodes);
+        released += count;
+        count = 0;
+      }
+      first = next;
+    }
+    allocator.deallocate_batch(sizeof(list_node), count, nodes);
+    released += count;
+  }
+  return released;
+}
 template <typename T, typename Default_allocator>
 void list<T, Default_allocator>::resize(size_t n) {
   if (n < _size) {
@@ -586,25 +617,53 @@ void list<T, Default_allocator>::resize(size_t n, const value_type &value) {
       last++;
     erase(begin(), last);
   } else {
-    for (int i = 0; i < n - _size; i++) {
-      list_node *tmp = construct(value);
-      insert(tmp);
-    }
+    allocate_and_fill_value(n - _size, value);
   }
 }
 
 // 申请空间并且使用value填满
 template <typename T, typename Default_allocator>
 void list<T, Default_allocator>::allocate_and_fill_value(
-    list_head& head, size_t n, const value_type &value) {
-  for (size_t i = 0; i < n; i++) {
+    size_t n, const value_type &value) {
+  allocate_nodes(n, [&](void *p) { new (p) list_node(nullptr, nullptr, value); });
+}
+
+template <typename T, typename Default_allocator>
+template <typename Iter>
+void list<T, Default_allocator>::allocate_and_copy(Iter first, size_t n) {
+  allocate_nodes(n, [&](void *p) {
+    new (p) list_node(nullptr, nullptr, *first);
+    ++first;
+  });
+}
+
+template <typename T, typename Default_allocator>
+template <typename Construct>
+void list<T, Default_allocator>::allocate_nodes(size_t n,
+                                                Construct construct_at) {
+  void *nodes[BATCH_NODES];
+  while (n > 0) {
+    size_t count = n < size_t(BATCH_NODES) ? n : size_t(BATCH_NODES);
+    allocator.allocate_batch(sizeof(list_node), count, nodes);
+    size_t i = 0;
+    try {
+      for (; i < count; i++)
+        construct_at(nodes[i]);
+    } catch (...) {
+      // 已经构造好的节点照常接上 没用到的还回去
+      for (size_t j = 0; j < i; j++)
+        insert(static_cast<list_node *>(nodes[j]));
+      _size += i;
+      allocator.deallocate_batch(sizeof(list_node), count - i, nodes + i);
+      throw;
+    }
     // 先构造node之后链接
-    list_node *new_node = construct(value);
-    // 开始插入
-    insert(new_node);
     //< A <-> B <-> C <-> head >
+    for (i = 0; i < count; i++)
+      insert(static_cast<list_node *>(nodes[i]));
+    _size += count;
+    n -= count;
   }
-  _size += n;
 }
 
 // 构造一个新节点
@@ -628,7 +687,7 @@ list<T, Default_allocator>::construct_in_place(Args... args) {
 }
 template <typename T, typename Default_allocator>
 void list<T, Default_allocator>::deconstruct(list_node *node) {
-  if constexpr (!std::is_trivially_destructible<value_type>()) {
+  if constexpr (!std::is_trivially_destructible_v<value_type>) {
     node->value.~value_type();
   }
   allocator.deallocate(static_cast<void *>(node), sizeof(list_node));
@@ -1,6 +1,7 @@
 #include "../include/my_list.h" // 你的头文件路径
 #include <chrono>
 #include <iostream>
+#include <string>
 #include <thread>
 
 using namespace m_stl;
@@ -100,10 +101,26 @@ void test_resize() {
   std::cout << "(Expected: 100)\n\n";
 }
 
+// 批量构造的节点通过allocate_batch申请 clear时通过deallocate_batch归还
+void test_bulk_construct() {
+  std::cout << "===== Testing Bulk Construct =====\n";
+  list<std::string> lst(200, std::string(32, 'x'));
+  std::cout << "Size: " << lst.size() << " (Expected 200)\n";
+  list<std::string> copy(lst);
+  size_t total = 0;
+  for (auto &x : copy)
+    total += x.size();
+  std::cout << "Copy chars: " << total << " (Expected 6400)\n";
+  copy.clear();
+  std::cout << "After clear: " << (copy.empty() ? "Passed" : "Failed")
+            << "\n\n";
+}
+
 int main() {
   test_basic_operations();
   test_copy_and_move();
   test_iterator_erase();
   test_resize();
+  test_bulk_construct();
   return 0;
 }
@@ -1,126 +0,0 @@
-#ifndef _M_ITERATOR_TRAITS_H_
-#define _M_ITERATOR_TRAITS_H_
-
-#include <cstddef>
-
-struct __true_type {};
-
-struct __false_type {};
-
-template <class type> struct m_type_traits {
-  typedef __true_type this_dummy_member_must_be_first;
-  typedef __false_type has_trivial_default_constructor;
-  typedef __false_type has_trivial_copy_constructor;
-  typedef __false_type has_trivial_assignment_operator;
-  typedef __false_type has_trivial_destructor;
-  typedef __false_type is_POD_type; // Plain Old Data
-};
-
-// Provide some specializations.  This is harmless for compilers that
-//  have built-in __types_traits support, and essential for compilers
-//  that don't.
-
-template<> struct m_type_traits<char> {
-  typedef __true_type has_trivial_default_constructor;
-  typedef __true_type has_trivial_copy_constructor;
-  typedef __true_type has_trivial_assignment_operator;
-  typedef __true_type has_trivial_destructor;
-  typedef __true_type is_POD_type;
-};
-
-template<> struct m_type_traits<signed char> {
-  typedef __true_type has_trivial_default_constructor;
-  typedef __true_type has_trivial_copy_constructor;
-  typedef __true_type has_trivial_assignment_operator;
-  typedef __true_type has_trivial_destructor;
-  typedef __true_type is_POD_type;
-};
-
-template<> struct m_type_traits<unsigned char> {
-  typedef __true_type has_trivial_default_constructor;
-  typedef __true_type has_trivial_copy_constructor;
-  typedef __true_type has_trivial_assignment_operator;
-  typedef __true_type has_trivial_destructor;
-  typedef __true_type is_POD_type;
-};
-
-template<> struct m_type_traits<short> {
-  typedef __true_type has_trivial_default_constructor;
-  typedef __true_type has_trivial_copy_constructor;
-  typedef __true_type has_trivial_assignment_operator;
-  typedef __true_type has_trivial_destructor;
-  typedef __true_type is_POD_type;
-};
-
-template<> struct m_type_traits<unsigned short> {
-  typedef __true_type has_trivial_default_constructor;
-  typedef __true_type has_trivial_copy_constructor;
-  typedef __true_type has_trivial_assignment_operator;
-  typedef __true_type has_trivial_destructor;
-  typedef __true_type is_POD_type;
-};
-
-template<> struct m_type_traits<int> {
-  typedef __true_type has_trivial_default_constructor;
-  typedef __true_type has_trivial_copy_constructor;
-  typedef __true_type has_trivial_assignment_operator;
-  typedef __true_type has_trivial_destructor;
-  typedef __true_type is_POD_type;
-};
-
-template<> struct m_type_traits<unsigned int> {
-  typedef __true_type has_trivial_default_constructor;
-  typedef __true_type has_trivial_copy_constructor;
-  typedef __true_type has_trivial_assignment_operator;
-  typedef __true_type has_trivial_destructor;
-  typedef __true_type is_POD_type;
-};
-
-template<> struct m_type_traits<long> {
-  typedef __true_type has_trivial_default_constructor;
-  typedef __true_type has_trivial_copy_constructor;
-  typedef __true_type has_trivial_assignment_operator;
-  typedef __true_type has_trivial_destructor;
-  typedef __true_type is_POD_type;
-};
-
-template<> struct m_type_traits<unsigned long> {
-  typedef __true_type has_trivial_default_constructor;
-  typedef __true_type has_trivial_copy_constructor;
-  typedef __true_type has_trivial_assignment_operator;
-  typedef __true_type has_trivial_destructor;
-  typedef __true_type is_POD_type;
-};
-
-template<> struct m_type_traits<float> {
-  typedef __true_type has_trivial_default_constructor;
-  typedef __true_type has_trivial_copy_constructor;
-  typedef __true_type has_trivial_assignment_operator;
-  typedef __true_type has_trivial_destructor;
-  typedef __true_type is_POD_type;
-};
- template <> struct m_type_traits<double> {
-  typedef __true_type has_trivial_default_constructor;
-  typedef __true_type has_trivial_copy_constructor;
-  typedef __true_type has_trivial_assignment_operator;
-  typedef __true_type has_trivial_destructor;
-  typedef __true_type is_POD_type;
-};
-
-template<> struct m_type_traits<long double> {
-  typedef __true_type has_trivial_default_constructor;
-  typedef __true_type has_trivial_copy_constructor;
-  typedef __true_type has_trivial_assignment_operator;
-  typedef __true_type has_trivial_destructor;
-  typedef __true_type is_POD_type;
-};
-
-template <class T> struct m_type_traits<T *> {
-  typedef __true_type has_trivial_default_constructor;
-  typedef __true_type has_trivial_copy_constructor;
-  typedef __true_type has_trivial_assignment_operator;
-  typedef __true_type has_trivial_destructor;
-  typedef __true_type is_POD_type;
-};
-
-#endif // _M_ITERATOR_TRAITS_H_
\ No newline at end of file
@@ -1,14 +1,32 @@
 #ifndef _MY_VECTOR_H_
 #define _MY_VECTOR_H_
 
-#include "./memoryPool.h"
+#include "../../memoryPool/include/arena_allocator.h"
+#include "../../memoryPool/include/memoryPool.h"
 #include "./uninitial.h"
+#include <algorithm>
 #include <csignal>
 #include <cstddef>
+#include <cstring>
+#include <initializer_list>
+#include <iterator>
+#include <memory>
 #include <stdexcept>
+#include <type_traits>
 #include <utility>
 
-template <typename T, typename Default_alloctor = my_malloc_allocator<0>>
+// 分配器提供try_expand/reallocate(比如my_malloc_allocator)时 扩容先尝试原地扩展
+// 元素可以平凡搬迁时再用reallocate 大块内存可以通过mremap移动而不复制
+template <typename Alloc, typename = void>
+struct has_reallocate : std::false_type {};
+
+template <typename Alloc>
+struct has_reallocate<
+    Alloc, std::void_t<decltype(Alloc::try_expand(nullptr, 0, 0)),
+                       decltype(Alloc::reallocate(nullptr, 0, 0))>>
+    : std::true_type {};
+
+template <typename T, typename Default_alloctor = my_malloc_allocator>
 class m_vector {
 public:
   // 类型定义
@@ -19,6 +37,7 @@ public:
   using const_reference = const T &;
   using iterator = value_type *;
   using const_iterator = const value_type *;
+  using size_type = std::size_t;
   using difference_type = ptrdiff_t;
 
   // 申请空间并填充空间
@@ -35,80 +54,225 @@ public:
   m_vector() : allocator(), start(0), finish(0), end_of_storage(0) {};
   explicit m_vector(std::size_t n) : allocator() { init(n, T()); }
   m_vector(size_t n, const value_type &value) : allocator() { init(n, value); }
+  template <typename InputIt,
+            typename = std::enable_if_t<!std::is_integral_v<InputIt>>>
+  m_vector(InputIt first, InputIt last) : m_vector() {
+    assign(first, last);
+  }
+  m_vector(std::initializer_list<value_type> list) : m_vector() {
+    assign(list.begin(), list.end());
+  }
 
-  // 重写拷贝运算符（深拷贝）
-  m_vector<T> &operator=(const value_type &other) {
-    if (this != &other) {
-      this->allocator = other.allocator;
-      this->start = other.start;
-      this->finish = other.finish;
-      this->end_of_storage = other.end_of_storage;
-    }
+  // 拷贝构造 按元素个数申请刚好的空间
+  m_vector(const m_vector &other) : m_vector() {
+    assign(other.begin(), other.end());
+  }
+  // 移动构造 直接接管对方的内存
+  m_vector(m_vector &&other) noexcept
+      : allocator(other.allocator), start(other.start), finish(other.finish),
+        end_of_storage(other.end_of_storage) {
+    other.start = other.finish = other.end_of_storage = nullptr;
+  }
+
+  // 拷贝赋值 容量够时复用原来的内存
+  m_vector &operator=(const m_vector &other) {
+    if (this != &other)
+      assign(other.begin(), other.end());
     return *this;
   }
-  // 移动拷贝构造
-  m_vector<T> &operator=(const value_type &&other) {
+  // 移动赋值 释放自己的内容后接管对方的内存
+  m_vector &operator=(m_vector &&other) noexcept {
     if (this != &other) {
-      this->allocator = other.allocator;
-      this->start = other.start;
-      this->finish = other.finish;
-      this->end_of_storage = other.end_of_storage;
-      other.~m_vector<T>();
+      m_vector tmp(std::move(other));
+      swap(tmp);
     }
     return *this;
   }
+  m_vector &operator=(std::initializer_list<value_type> list) {
+    assign(list.begin(), list.end());
+    return *this;
+  }
+
+  // 用n个value或者一段区间替换全部内容 需要的元素个数超过容量时只申请一次
+  void assign(size_type n, const value_type &value);
+  template <typename InputIt,
+            typename = std::enable_if_t<!std::is_integral_v<InputIt>>>
+  void assign(InputIt first, InputIt last);
+  void assign(std::initializer_list<value_type> list) {
+    assign(list.begin(), list.end());
+  }
 
   // 重载运算符
   reference operator[](size_t n) { return start[n]; }
+  const_reference operator[](size_t n) const { return start[n]; }
 
   // 基础功能函数
-  difference_type size() { return difference_type(finish - start); }
-  difference_type capacity() { return difference_type(end_of_storage - start); }
+  size_type size() const { return size_type(finish - start); }
+  size_type capacity() const { return size_type(end_of_storage - start); }
+  bool empty() const { return start == finish; }
 
   iterator begin() { return start; }
   const_iterator begin() const { return start; }
-  iterator end() { return end_of_storage; }
-  const_iterator end() const { return end_of_storage; }
+  const_iterator cbegin() const { return start; }
+  iterator end() { return finish; }
+  const_iterator end() const { return finish; }
+  const_iterator cend() const { return finish; }
+
+  reference front() { return *start; }
+  const_reference front() const { return *start; }
+  reference back() { return *(finish - 1); }
+  const_reference back() const { return *(finish - 1); }
+  pointer data() { return start; }
+  const_pointer data() const { return start; }
+
+  // 把容量改成刚好n个元素 n不超过当前容量时什么也不做
+  void reserve(size_type n) {
+    if (n > capacity())
+      relocate_storage(n);
+  }
+  // 把容量缩到和元素个数一样 没有元素时释放全部内存
+  void shrink_to_fit();
+  // 变小时析构末尾多出的元素 变大时在末尾补上值初始化或者value的拷贝
+  void resize(size_type n);
+  void resize(size_type n, const value_type &value);
+  // 析构全部元素 保留容量
+  void clear() { erase_at_end(start); }
 
   void push_back(const value_type &value);
-  iterator insert(iterator pos, const_reference value);
+  void push_back(value_type &&value) { emplace_back(std::move(value)); }
+  void pop_back() {
+    --finish;
+    ::destroy_at(finish);
+  }
+
+  // 在pos之前插入 返回指向第一个新元素的迭代器
+  // 容量够时原地后移 否则只申请一次新内存 新元素和旧元素一起放进去
+  iterator insert(const_iterator pos, const_reference value) {
+    return emplace(pos, value);
+  }
+  iterator insert(const_iterator pos, value_type &&value) {
+    return emplace(pos, std::move(value));
+  }
+  iterator insert(const_iterator pos, size_type n, const value_type &value);
+  template <typename InputIt,
+            typename = std::enable_if_t<!std::is_integral_v<InputIt>>>
+  iterator insert(const_iterator pos, InputIt first, InputIt last);
+  iterator insert(const_iterator pos, std::initializer_list<value_type> list) {
+    return insert(pos, list.begin(), list.end());
+  }
+
+  template <typename... Args> iterator emplace(const_iterator pos, Args &&...args);
+  template <typename... Args> void emplace_back(Args &&...args);
 
-  template <typename... Args> void emplace_back(Args... args);
+  // 删除元素后把后面的元素前移 返回删除位置
+  iterator erase(const_iterator pos) { return erase(pos, pos + 1); }
+  iterator erase(const_iterator first, const_iterator last);
+
+  void swap(m_vector &other) noexcept {
+    std::swap(allocator, other.allocator);
+    std::swap(start, other.start);
+    std::swap(finish, other.finish);
+    std::swap(end_of_storage, other.end_of_storage);
+  }
 
   reference at(size_t i) {
-    if (i <= (finish - start)) {
+    if (i < size()) {
       return *(start + i);
     } else {
-      throw std::out_of_range("");
+      throw std::out_of_range("m_vector::at");
     }
   }
 
   const_reference at(size_t i) const {
-    if (i <= (finish - start)) {
+    if (i < size()) {
       return *(start + i);
     } else {
-      throw std::out_of_range("");
+      throw std::out_of_range("m_vector::at");
     }
   }
 
   // 析构函数
   ~m_vector() {
+    // 分配器整体释放并且元素不需要析构时什么也不用做
+    if constexpr (skip_destroy_v<Default_alloctor, value_type>)
+      return;
     if (start != nullptr) {
-      iterator tmp = start;
-      for (; tmp != end_of_storage; tmp++) {
-        deconstruct<iterator, value_type>(tmp);
-      }
-      allocator.deallocate(start,
-                           (end_of_storage - start) * sizeof(value_type));
+      destroy_range(start, finish);
+      deallocate_storage();
     }
   }
 
 protected:
-  void extend_capacity(const value_type &value);
+  // 满了之后在末尾构造一个新元素 参数可能引用容器里的元素
+  template <typename... Args> void extend_and_emplace(Args &&...args);
   void extend_capacity();
+  // 把已有元素搬到一块new_size个元素的新内存上 然后释放旧内存
+  void relocate_storage(std::size_t new_size);
+  // 用分配器的try_expand/reallocate把容量改成new_size 做不到时返回false
+  // 成功时start可能变了 已有元素的内容不变
+  bool reallocate_storage(std::size_t new_size);
+  std::size_t next_capacity() const {
+    return end_of_storage != start ? (end_of_storage - start) * 2 : 10;
+  }
+  // 再放n个元素需要的新容量 至少翻倍 保证连续插入是均摊常数时间
+  size_type grow_capacity(size_type n) const {
+    size_type doubled = next_capacity();
+    return size() + n > doubled ? size() + n : doubled;
+  }
 
-  void copy(iterator src_begin, iterator src_end, iterator des_begin,
-            iterator des_end);
+  // 把pos前后的旧元素搬到new_mem上 中间留出n个已经构造好的新元素
+  // 然后释放旧内存 失败时析构这n个新元素并释放new_mem 旧内容不变
+  void relocate_with_gap(iterator pos, size_type n, iterator new_mem,
+                         size_type new_size);
+  // 可以平凡搬迁时 把[pos, finish)按字节后移或者前移n个位置
+  void shift_tail(iterator pos, size_type n) {
+    move_trivial(pos + n, pos, finish - pos);
+  }
+  void unshift_tail(iterator pos, size_type n) {
+    move_trivial(pos, pos + n, finish - pos);
+  }
+  // 在未初始化的内存上构造 可以平凡复制时按字节整段写入
+  static iterator fill_construct(iterator dest, size_type n,
+                                 const value_type &value) {
+    if constexpr (std::is_trivially_copyable_v<value_type>)
+      return fill_trivial(dest, n, value);
+    else
+      return std::uninitialized_fill_n(dest, n, value);
+  }
+  template <typename InputIt>
+  static iterator copy_construct(InputIt first, InputIt last, iterator dest) {
+    if constexpr (std::is_trivially_copyable_v<value_type> &&
+                  (std::is_same_v<InputIt, iterator> ||
+                   std::is_same_v<InputIt, const_iterator>)) {
+      move_trivial(dest, first, last - first);
+      return dest + (last - first);
+    } else {
+      return std::uninitialized_copy(first, last, dest);
+    }
+  }
+  // 在末尾值初始化n个元素
+  void default_append(size_type n);
+  // 析构[pos, finish)的元素
+  void erase_at_end(iterator pos) {
+    destroy_range(pos, finish);
+    finish = pos;
+  }
+  // 可以平凡析构的类型不需要遍历
+  static void destroy_range(iterator first, iterator last) {
+    if constexpr (!std::is_trivially_destructible_v<value_type>)
+      for (; first != last; ++first)
+        first->~value_type();
+  }
+  iterator allocate_storage(size_type n) {
+    return static_cast<iterator>(allocator.allocate(n * sizeof(value_type)));
+  }
+  void deallocate_storage() {
+    if (start != nullptr)
+      allocator.deallocate(start, (end_of_storage - start) * sizeof(value_type));
+  }
+  iterator to_iterator(const_iterator pos) {
+    return start + (pos - start);
+  }
 
 private:
   Default_alloctor allocator;
@@ -132,98 +296,431 @@ m_vector<T, Default_alloctor>::allocate_and_fill(std::size_t n,
   }
 }
 
+// 先在新内存里构造新元素再搬迁旧元素 这样参数引用的旧元素还有效
 template <typename T, typename Default_alloctor>
-void m_vector<T, Default_alloctor>::extend_capacity(const value_type &value) {
+template <typename... Args>
+void m_vector<T, Default_alloctor>::extend_and_emplace(Args &&...args) {
   // 申请新空间
-  std::size_t new_size =
-      (end_of_storage - start) != 0 ? (end_of_storage - start) * 2 : 10;
+  std::size_t new_size = next_capacity();
+  std::size_t old_size = finish - start;
+  if constexpr (has_reallocate<Default_alloctor>::value) {
+    if (start != nullptr) {
+      if constexpr (is_trivially_relocatable_v<value_type>) {
+        // reallocate可能移动内存 先在旁边构造新元素 再按字节搬到末尾
+        alignas(value_type) unsigned char buf[sizeof(value_type)];
+        value_type *tmp = reinterpret_cast<value_type *>(buf);
+        ::construct_at(tmp, std::forward<Args>(args)...);
+        try {
+          reallocate_storage(new_size);
+        } catch (...) {
+          ::destroy_at(tmp);
+          throw;
+        }
+        std::memcpy(static_cast<void *>(finish), buf, sizeof(value_type));
+        ++finish;
+        return;
+      } else if (reallocate_storage(new_size)) {
+        // 只能是原地扩展 参数引用的元素没有移动
+        ::construct_at(finish, std::forward<Args>(args)...);
+        ++finish;
+        return;
+      }
+    }
+  }
   iterator new_mem =
       static_cast<iterator>(allocator.allocate(new_size * sizeof(value_type)));
-  // 复制内容
-  iterator new_finish = new_mem;
-  iterator old_start = start;
-  if (start != nullptr) {
-    for (; old_start != end_of_storage; old_start++, new_finish++) {
-      new (new_finish) value_type(*old_start);
-      // 将旧空间中的对象非平凡类型析构
-      // 这里要使用函数重载 看是不是POD
-      deconstruct<iterator, value_type>(old_start);
-    }
-
-    // 释放原内存
-    allocator.deallocate(start, (end_of_storage - start) * sizeof(value_type));
+  try {
+    ::construct_at(new_mem + old_size, std::forward<Args>(args)...);
+  } catch (...) {
+    allocator.deallocate(new_mem, new_size * sizeof(value_type));
+    throw;
+  }
+  // 搬迁旧内容 只有finish之前的是构造过的对象
+  try {
+    uninit_relocate(start, finish, new_mem);
+  } catch (...) {
+    ::destroy_at(new_mem + old_size);
+    allocator.deallocate(new_mem, new_size * sizeof(value_type));
+    throw;
   }
+  if (start != nullptr) // 释放原内存
+    allocator.deallocate(start, (end_of_storage - start) * sizeof(value_type));
   start = new_mem;
-  finish = new_finish;
+  finish = new_mem + old_size + 1;
   end_of_storage = start + new_size;
-  // 插入新内容
-  push_back(value);
 }
 
 template <typename T, typename Default_alloctor>
 void m_vector<T, Default_alloctor>::extend_capacity() {
+  relocate_storage(next_capacity());
+}
+
+template <typename T, typename Default_alloctor>
+void m_vector<T, Default_alloctor>::relocate_storage(std::size_t new_size) {
+  if (reallocate_storage(new_size))
+    return;
   // 申请新空间
-  std::size_t new_size =
-      (end_of_storage - start) != 0 ? (end_of_storage - start) * 2 : 10;
   iterator new_mem =
       static_cast<iterator>(allocator.allocate(new_size * sizeof(value_type)));
-  // 复制内容
-  iterator new_finish = new_mem;
-  iterator old_start = start;
-  if (start != nullptr) {
-    for (; old_start != end_of_storage; old_start++, new_finish++) {
-      new (new_finish) value_type(*old_start);
-      // 将旧空间中的对象非平凡类型析构
-      // 这里要使用函数重载 看是不是POD
-      deconstruct<iterator, value_type>(old_start);
-    }
-
-    // 释放原内存
-    allocator.deallocate(start, (end_of_storage - start) * sizeof(value_type));
+  // 搬迁内容 失败时旧内容保持不变
+  iterator new_finish;
+  try {
+    new_finish = uninit_relocate(start, finish, new_mem);
+  } catch (...) {
+    allocator.deallocate(new_mem, new_size * sizeof(value_type));
+    throw;
   }
+  if (start != nullptr) // 释放原内存
+    allocator.deallocate(start, (end_of_storage - start) * sizeof(value_type));
   start = new_mem;
   finish = new_finish;
   end_of_storage = start + new_size;
 }
 
+template <typename T, typename Default_alloctor>
+bool m_vector<T, Default_alloctor>::reallocate_storage(std::size_t new_size) {
+  if constexpr (has_reallocate<Default_alloctor>::value) {
+    if (start == nullptr)
+      return false;
+    std::size_t old_bytes = (end_of_storage - start) * sizeof(value_type);
+    std::size_t new_bytes = new_size * sizeof(value_type);
+    if (allocator.try_expand(start, old_bytes, new_bytes)) {
+      end_of_storage = start + new_size;
+      return true;
+    }
+    // 能平凡搬迁的元素可以由分配器按字节搬走 不需要逐个移动
+    if constexpr (is_trivially_relocatable_v<value_type>) {
+      std::size_t size = finish - start;
+      start = static_cast<iterator>(
+          allocator.reallocate(start, old_bytes, new_bytes));
+      finish = start + size;
+      end_of_storage = start + new_size;
+      return true;
+    }
+  }
+  return false;
+}
+
 template <typename T, typename Default_alloctor>
 void m_vector<T, Default_alloctor>::push_back(const value_type &value) {
   if (finish != end_of_storage) {
-    uninit<iterator, value_type>(finish, 1, value);
+    ::construct_at(finish, value);
+    ++finish;
   } else {
-    extend_capacity(value);
+    extend_and_emplace(value);
   }
 }
 template <typename T, typename Default_alloctor>
-typename m_vector<T, Default_alloctor>::iterator
-m_vector<T, Default_alloctor>::insert(iterator pos, const_reference value) {
-  // 满了
-  if (finish == end_of_storage) {
-    difference_type n = pos - start;
-    extend_capacity();
-    pos = start + n;
-  }
-  copy(pos, finish, pos + 1, finish + 1);
-  new (pos) value_type(value);
-  return pos;
+template <typename... Args>
+void m_vector<T, Default_alloctor>::emplace_back(Args &&...args) {
+  if (finish != end_of_storage) {
+    ::construct_at(finish, std::forward<Args>(args)...);
+    ++finish;
+  } else {
+    extend_and_emplace(std::forward<Args>(args)...);
+  }
 }
 
 template <typename T, typename Default_alloctor>
 template <typename... Args>
-void m_vector<T, Default_alloctor>::emplace_back(Args... args) {
+typename m_vector<T, Default_alloctor>::iterator
+m_vector<T, Default_alloctor>::emplace(const_iterator position,
+                                       Args &&...args) {
+  iterator pos = to_iterator(position);
+  size_type offset = pos - start;
+  if (pos == finish) {
+    emplace_back(std::forward<Args>(args)...);
+    return start + offset;
+  }
   if (finish != end_of_storage) {
-    construct_at(finish++,std::forward<Args>(args)...);
+    // 参数可能引用后移范围里的元素 先构造好再放进去
+    value_type tmp(std::forward<Args>(args)...);
+    if constexpr (is_trivially_relocatable_v<value_type>) {
+      shift_tail(pos, 1);
+      ++finish;
+      try {
+        ::construct_at(pos, std::move(tmp));
+      } catch (...) {
+        --finish;
+        unshift_tail(pos, 1);
+        throw;
+      }
+    } else {
+      ::construct_at(finish, std::move(*(finish - 1)));
+      ++finish;
+      std::move_backward(pos, finish - 2, finish - 1);
+      *pos = std::move(tmp);
+    }
+    return pos;
+  }
+  // 新元素直接构造在新内存上 参数引用的旧元素还没有移动
+  size_type new_size = next_capacity();
+  iterator new_mem = allocate_storage(new_size);
+  try {
+    ::construct_at(new_mem + offset, std::forward<Args>(args)...);
+  } catch (...) {
+    allocator.deallocate(new_mem, new_size * sizeof(value_type));
+    throw;
+  }
+  relocate_with_gap(pos, 1, new_mem, new_size);
+  return start + offset;
+}
+
+template <typename T, typename Default_alloctor>
+typename m_vector<T, Default_alloctor>::iterator
+m_vector<T, Default_alloctor>::insert(const_iterator position, size_type n,
+                                      const value_type &value) {
+  iterator pos = to_iterator(position);
+  if (n == 0)
+    return pos;
+  if (size_type(end_of_storage - finish) >= n) {
+    // value可能引用容器里的元素 后移之前先复制一份
+    value_type copy(value);
+    if constexpr (is_trivially_relocatable_v<value_type>) {
+      // 后面的元素整段按字节后移 空出来的位置是未初始化的内存
+      shift_tail(pos, n);
+      finish += n;
+      try {
+        fill_construct(pos, n, copy);
+      } catch (...) {
+        finish -= n;
+        unshift_tail(pos, n);
+        throw;
+      }
+    } else {
+      iterator old_finish = finish;
+      size_type elems_after = finish - pos;
+      if (elems_after > n) {
+        finish = std::uninitialized_move(finish - n, finish, finish);
+        std::move_backward(pos, old_finish - n, old_finish);
+        std::fill(pos, pos + n, copy);
+      } else {
+        finish = std::uninitialized_fill_n(finish, n - elems_after, copy);
+        finish = std::uninitialized_move(pos, old_finish, finish);
+        std::fill(pos, old_finish, copy);
+      }
+    }
+    return pos;
+  }
+  size_type offset = pos - start;
+  size_type new_size = grow_capacity(n);
+  iterator new_mem = allocate_storage(new_size);
+  try {
+    fill_construct(new_mem + offset, n, value);
+  } catch (...) {
+    allocator.deallocate(new_mem, new_size * sizeof(value_type));
+    throw;
+  }
+  relocate_with_gap(pos, n, new_mem, new_size);
+  return start + offset;
+}
+
+// 前向迭代器可以先数出个数 容量不够时只申请一次
+// 输入迭代器只能遍历一遍 逐个插入
+template <typename T, typename Default_alloctor>
+template <typename InputIt, typename>
+typename m_vector<T, Default_alloctor>::iterator
+m_vector<T, Default_alloctor>::insert(const_iterator position, InputIt first,
+                                      InputIt last) {
+  iterator pos = to_iterator(position);
+  using category = typename std::iterator_traits<InputIt>::iterator_category;
+  if constexpr (!std::is_base_of_v<std::forward_iterator_tag, category>) {
+    size_type offset = pos - start;
+    for (iterator cur = pos; first != last; ++first, ++cur)
+      cur = emplace(cur, *first);
+    return start + offset;
   } else {
-    emplace_back(std::forward<Args>(args)...);
+    size_type n = std::distance(first, last);
+    if (n == 0)
+      return pos;
+    if (size_type(end_of_storage - finish) >= n) {
+      if constexpr (is_trivially_relocatable_v<value_type>) {
+        shift_tail(pos, n);
+        finish += n;
+        try {
+          copy_construct(first, last, pos);
+        } catch (...) {
+          finish -= n;
+          unshift_tail(pos, n);
+          throw;
+        }
+      } else {
+        iterator old_finish = finish;
+        size_type elems_after = finish - pos;
+        if (elems_after > n) {
+          finish = std::uninitialized_move(finish - n, finish, finish);
+          std::move_backward(pos, old_finish - n, old_finish);
+          std::copy(first, last, pos);
+        } else {
+          InputIt mid = std::next(first, elems_after);
+          finish = std::uninitialized_copy(mid, last, finish);
+          finish = std::uninitialized_move(pos, old_finish, finish);
+          std::copy(first, mid, pos);
+        }
+      }
+      return pos;
+    }
+    size_type offset = pos - start;
+    size_type new_size = grow_capacity(n);
+    iterator new_mem = allocate_storage(new_size);
+    try {
+      copy_construct(first, last, new_mem + offset);
+    } catch (...) {
+      allocator.deallocate(new_mem, new_size * sizeof(value_type));
+      throw;
+    }
+    relocate_with_gap(pos, n, new_mem, new_size);
+    return start + offset;
+  }
+}
+
+template <typename T, typename Default_alloctor>
+typename m_vector<T, Default_alloctor>::iterator
+m_vector<T, Default_alloctor>::erase(const_iterator first,
+                                     const_iterator last) {
+  iterator pos = to_iterator(first);
+  iterator end = to_iterator(last);
+  if (pos == end)
+    return pos;
+  if constexpr (is_trivially_relocatable_v<value_type>) {
+    // 先析构被删除的元素 后面的元素整段按字节前移
+    destroy_range(pos, end);
+    move_trivial(pos, end, finish - end);
+    finish -= end - pos;
+  } else {
+    erase_at_end(std::move(end, finish, pos));
   }
+  return pos;
 }
 
 template <typename T, typename Default_alloctor>
-void m_vector<T, Default_alloctor>::copy(iterator src_begin, iterator src_end,
-                                         iterator des_begin, iterator des_end) {
-  for (; src_end != src_begin; src_end--, des_end--) {
-    *des_end = std::move(*src_end);
+void m_vector<T, Default_alloctor>::assign(size_type n,
+                                           const value_type &value) {
+  if (n > capacity()) {
+    // value可能引用旧元素 新内存填好之后再释放旧内存
+    m_vector tmp(n, value);
+    swap(tmp);
+  } else if (n > size()) {
+    std::fill(start, finish, value);
+    finish = fill_construct(finish, n - size(), value);
+  } else {
+    std::fill_n(start, n, value);
+    erase_at_end(start + n);
   }
-  finish++;
+}
+
+template <typename T, typename Default_alloctor>
+template <typename InputIt, typename>
+void m_vector<T, Default_alloctor>::assign(InputIt first, InputIt last) {
+  using category = typename std::iterator_traits<InputIt>::iterator_category;
+  if constexpr (!std::is_base_of_v<std::forward_iterator_tag, category>) {
+    clear();
+    for (; first != last; ++first)
+      emplace_back(*first);
+  } else {
+    size_type n = std::distance(first, last);
+    if (n > capacity()) {
+      iterator new_mem = allocate_storage(n);
+      try {
+        copy_construct(first, last, new_mem);
+      } catch (...) {
+        allocator.deallocate(new_mem, n * sizeof(value_type));
+        throw;
+      }
+      destroy_range(start, finish);
+      deallocate_storage();
+      start = new_mem;
+      finish = end_of_storage = new_mem + n;
+    } else if (n > size()) {
+      InputIt mid = std::next(first, size());
+      std::copy(first, mid, start);
+      finish = copy_construct(mid, last, finish);
+    } else {
+      erase_at_end(std::copy(first, last, start));
+    }
+  }
+}
+
+template <typename T, typename Default_alloctor>
+void m_vector<T, Default_alloctor>::shrink_to_fit() {
+  if (finish == end_of_storage)
+    return;
+  if (start == finish) {
+    deallocate_storage();
+    start = finish = end_of_storage = nullptr;
+    return;
+  }
+  relocate_storage(size());
+}
+
+template <typename T, typename Default_alloctor>
+void m_vector<T, Default_alloctor>::resize(size_type n) {
+  if (n < size())
+    erase_at_end(start + n);
+  else if (n > size())
+    default_append(n - size());
+}
+
+template <typename T, typename Default_alloctor>
+void m_vector<T, Default_alloctor>::resize(size_type n,
+                                           const value_type &value) {
+  if (n < size())
+    erase_at_end(start + n);
+  else if (n > size())
+    insert(cend(), n - size(), value);
+}
+
+template <typename T, typename Default_alloctor>
+void m_vector<T, Default_alloctor>::default_append(size_type n) {
+  if (size_type(end_of_storage - finish) < n)
+    relocate_storage(grow_capacity(n));
+  // 平凡的默认构造就是全部清零 整段memset
+  if constexpr (std::is_trivially_default_constructible_v<value_type> &&
+                std::is_trivially_copyable_v<value_type>) {
+    finish = fill_trivial(finish, n, value_type());
+  } else {
+    iterator cur = finish;
+    try {
+      for (; cur != finish + n; ++cur)
+        ::construct_at(cur);
+    } catch (...) {
+      destroy_range(finish, cur);
+      throw;
+    }
+    finish = cur;
+  }
+}
+
+template <typename T, typename Default_alloctor>
+void m_vector<T, Default_alloctor>::relocate_with_gap(iterator pos,
+                                                      size_type n,
+                                                      iterator new_mem,
+                                                      size_type new_size) {
+  size_type offset = pos - start;
+  size_type old_size = finish - start;
+  if constexpr (is_trivially_relocatable_v<value_type>) {
+    uninit_relocate(start, pos, new_mem);
+    uninit_relocate(pos, finish, new_mem + offset + n);
+  } else {
+    // 两段都构造成功之后才析构旧元素 任何一步失败旧内容都不变
+    try {
+      uninit_move_if_noexcept(start, pos, new_mem);
+      try {
+        uninit_move_if_noexcept(pos, finish, new_mem + offset + n);
+      } catch (...) {
+        destroy_range(new_mem, new_mem + offset);
+        throw;
+      }
+    } catch (...) {
+      destroy_range(new_mem + offset, new_mem + offset + n);
+      allocator.deallocate(new_mem, new_size * sizeof(value_type));
+      throw;
+    }
+    destroy_range(start, finish);
+  }
+  deallocate_storage();
+  start = new_mem;
+  finish = new_mem + old_size + n;
+  end_of_storage = new_mem + new_size;
 }
 #endif // _MY_VECTOR_H_
\ No newline at end of file
@@ -1,54 +1,201 @@
 #ifndef _UNINITIAL_H_
 #define _UNINITIAL_H_
 
-#include "./m_iterator_traits.h"
 #include <cstddef>
+#include <cstring>
+#include <memory>
+#include <numeric>
+#include <type_traits>
 #include <utility>
 
-template <typename Forward_iterator, typename value_type>
-void __uninit(Forward_iterator begin, Forward_iterator end,
-              const value_type &value,
-              __false_type) // 这个是非平凡类型的重载函数
-{
-  for (;begin != end;begin++) {
-    new (begin) value_type(value);
-  }
+// x86上用SSE2/AVX2写可以平凡复制的元素 运行时按CPU支持的指令集选择
+// 定义VECTOR_SIMD_OFF时全部用逐个元素的普通循环
+#if (defined(__x86_64__) || defined(__i386__)) && defined(__GNUC__) &&          \
+    !defined(VECTOR_SIMD_OFF)
+#define SIMD_ON true
+#include <immintrin.h>
+#else
+#define SIMD_ON false
+#endif // (defined(__x86_64__) || defined(__i386__)) && defined(__GNUC__)
+
+#if SIMD_ON
+namespace simd_kernel {
+// 填充时先把元素的字节重复写满一个block 长度是元素大小和向量宽度的公倍数
+// 元素大小和向量宽度的最小公倍数超过4个向量时不处理 交给普通循环
+// 比如1 2 3 4 6 8 12 16 24 32 48 64字节的元素都可以 5 7 40这样的不行
+// 小于这些字节数时准备向量和block的开销比循环本身还大
+// 1 2 4 8字节的元素直接广播 普通循环一次只写一个元素 256字节就值得用向量
+// 其他大小要先拼block 而且编译器对16字节以上的元素本来就按向量复制
+enum { MIN_BROADCAST_BYTES = 256, MIN_BLOCK_BYTES = 2048 };
+
+// 返回block里有效的字节数 是元素大小的整数倍也是width的整数倍 不超过4个向量
+inline std::size_t build_block(unsigned char *block, const void *value,
+                               std::size_t size, std::size_t width) {
+  std::size_t period = std::lcm(size, width);
+  if (period > 4 * width)
+    return 0;
+  std::size_t len = 4 * width / period * period;
+  // 写一个元素之后每次把已经写好的部分复制一遍 次数是对数级的
+  std::memcpy(block, value, size);
+  for (std::size_t done = size; done < len; done *= 2)
+    std::memcpy(block + done, block, done < len - done ? done : len - done);
+  return len;
 }
 
-template <typename Forward_iterator, typename value_type>
-void __uninit(Forward_iterator begin, Forward_iterator end,
-              const value_type &value,__true_type) // 这个是平凡类型的重载函数
-{
-  for (; begin != end; begin++) {
-    *begin = value;    
+// 1 2 4 8字节的元素直接广播到整个向量 其他大小先写好block再读进向量
+// 主循环每次写一整个block(4个或者3个向量) 写的位置总是block长度的整数倍
+// 所以不足一个block的尾部也从周期的开头开始 直接从block里memcpy
+// 向量都用具名变量 放在数组里按下标取时会被放到栈上
+__attribute__((target("sse2"))) inline bool
+fill_sse2(void *dest, const void *value, std::size_t size, std::size_t count) {
+  alignas(16) unsigned char block[64] = {};
+  __m128i *b = reinterpret_cast<__m128i *>(block);
+  std::size_t len = 64;
+  __m128i v0;
+  if (size <= 8 && (size & (size - 1)) == 0) {
+    long long x = 0;
+    std::memcpy(&x, value, size);
+    if (size == 1)
+      v0 = _mm_set1_epi8(char(x));
+    else if (size == 2)
+      v0 = _mm_set1_epi16(short(x));
+    else if (size == 4)
+      v0 = _mm_set1_epi32(int(x));
+    else
+      v0 = _mm_set1_epi64x(x);
+    _mm_store_si128(b, v0);
+    _mm_store_si128(b + 1, v0);
+    _mm_store_si128(b + 2, v0);
+    _mm_store_si128(b + 3, v0);
+  } else {
+    len = build_block(block, value, size, 16);
+    if (len == 0)
+      return false;
+    v0 = _mm_load_si128(b);
   }
+  __m128i v1 = _mm_load_si128(b + 1), v2 = _mm_load_si128(b + 2);
+  unsigned char *d = static_cast<unsigned char *>(dest);
+  std::size_t bytes = size * count, i = 0;
+  if (len == 64) {
+    __m128i v3 = _mm_load_si128(b + 3);
+    for (; i + 64 <= bytes; i += 64) {
+      __m128i *p = reinterpret_cast<__m128i *>(d + i);
+      _mm_storeu_si128(p, v0);
+      _mm_storeu_si128(p + 1, v1);
+      _mm_storeu_si128(p + 2, v2);
+      _mm_storeu_si128(p + 3, v3);
+    }
+  } else {
+    for (; i + 48 <= bytes; i += 48) {
+      __m128i *p = reinterpret_cast<__m128i *>(d + i);
+      _mm_storeu_si128(p, v0);
+      _mm_storeu_si128(p + 1, v1);
+      _mm_storeu_si128(p + 2, v2);
+    }
+  }
+  std::memcpy(d + i, block, bytes - i);
+  return true;
 }
 
-template <typename Forward_iterator, typename value_type>
-void uninit(Forward_iterator iterator, std::size_t n, const value_type &value) {
-  typedef typename m_type_traits<value_type>::is_POD_type is_POD;
-  return __uninit(iterator, iterator + n, value, is_POD());
+__attribute__((target("avx2"))) inline bool
+fill_avx2(void *dest, const void *value, std::size_t size, std::size_t count) {
+  alignas(32) unsigned char block[128] = {};
+  __m256i *b = reinterpret_cast<__m256i *>(block);
+  std::size_t len = 128;
+  __m256i v0;
+  if (size <= 8 && (size & (size - 1)) == 0) {
+    long long x = 0;
+    std::memcpy(&x, value, size);
+    if (size == 1)
+      v0 = _mm256_set1_epi8(char(x));
+    else if (size == 2)
+      v0 = _mm256_set1_epi16(short(x));
+    else if (size == 4)
+      v0 = _mm256_set1_epi32(int(x));
+    else
+      v0 = _mm256_set1_epi64x(x);
+    _mm256_store_si256(b, v0);
+    _mm256_store_si256(b + 1, v0);
+    _mm256_store_si256(b + 2, v0);
+    _mm256_store_si256(b + 3, v0);
+  } else {
+    len = build_block(block, value, size, 32);
+    if (len == 0)
+      return false;
+    v0 = _mm256_load_si256(b);
+  }
+  __m256i v1 = _mm256_load_si256(b + 1), v2 = _mm256_load_si256(b + 2);
+  unsigned char *d = static_cast<unsigned char *>(dest);
+  std::size_t bytes = size * count, i = 0;
+  if (len == 128) {
+    __m256i v3 = _mm256_load_si256(b + 3);
+    for (; i + 128 <= bytes; i += 128) {
+      __m256i *p = reinterpret_cast<__m256i *>(d + i);
+      _mm256_storeu_si256(p, v0);
+      _mm256_storeu_si256(p + 1, v1);
+      _mm256_storeu_si256(p + 2, v2);
+      _mm256_storeu_si256(p + 3, v3);
+    }
+  } else {
+    for (; i + 96 <= bytes; i += 96) {
+      __m256i *p = reinterpret_cast<__m256i *>(d + i);
+      _mm256_storeu_si256(p, v0);
+      _mm256_storeu_si256(p + 1, v1);
+      _mm256_storeu_si256(p + 2, v2);
+    }
+  }
+  std::memcpy(d + i, block, bytes - i);
+  return true;
 }
 
+using fill_kernel = bool (*)(void *, const void *, std::size_t, std::size_t);
 
-template <typename Forward_iterator, typename value_type>
-void __deconstruct(Forward_iterator iterator,
-                   __true_type) // 这个是平凡类型的重载函数
-{
-  return;
+// 第一次调用时检测CPU 之后直接用选好的函数
+inline fill_kernel dispatch() {
+  static const fill_kernel k = [] {
+    __builtin_cpu_init();
+    return __builtin_cpu_supports("avx2") ? fill_avx2 : fill_sse2;
+  }();
+  return k;
 }
+} // namespace simd_kernel
+#endif // SIMD_ON
 
-template <typename Forward_iterator, typename value_type>
-void __deconstruct(Forward_iterator iterator,
-                   __false_type) // 这个是平凡类型的重载函数
-{
-  (*iterator).~value_type();
+// 把可以平凡复制的value写到dest开始的n个未初始化位置
+// 字节数够多时用向量指令 一次写一整个重复的block
+template <typename T> T *fill_trivial(T *dest, std::size_t n, const T &value) {
+  static_assert(std::is_trivially_copyable_v<T>);
+  // 全是0字节的元素(值初始化的整数 浮点数和它们组成的聚合体)直接memset
+  // 按字节比较 填充字节不是0时走下面的复制 结果一样
+  static const unsigned char zero[sizeof(T)] = {};
+  if (std::memcmp(&value, zero, sizeof(T)) == 0) {
+    if (n != 0)
+      std::memset(static_cast<void *>(dest), 0, n * sizeof(T));
+    return dest + n;
+  }
+#if SIMD_ON
+  constexpr bool broadcast = sizeof(T) <= 8 && (sizeof(T) & (sizeof(T) - 1)) == 0;
+  constexpr std::size_t min_bytes = broadcast
+                                        ? simd_kernel::MIN_BROADCAST_BYTES
+                                        : simd_kernel::MIN_BLOCK_BYTES;
+  if (n * sizeof(T) >= min_bytes &&
+      simd_kernel::dispatch()(dest, &value, sizeof(T), n))
+    return dest + n;
+#endif // SIMD_ON
+  const T tmp = value;
+  for (std::size_t i = 0; i < n; i++)
+    std::memcpy(static_cast<void *>(dest + i), &tmp, sizeof(T));
+  return dest + n;
 }
 
-template <typename Forward_iterator, typename value_type>
-void deconstruct(Forward_iterator iterator) {
-  typedef typename m_type_traits<value_type>::is_POD_type is_POD;
-  return __deconstruct<Forward_iterator,value_type>(iterator, is_POD());
+// 按字节复制n个元素 源和目标可以重叠
+// 扩容时搬迁元素 insert和erase时后移或者前移后面的元素都走这里
+// libc的memmove已经按CPU选择了向量实现 自己写的复制内核测下来比它慢
+template <typename T> void move_trivial(T *dest, const T *src, std::size_t n) {
+  if (n == 0) // 空的m_vector里指针是nullptr
+    return;
+  std::memmove(static_cast<void *>(dest), static_cast<const void *>(src),
+               n * sizeof(T));
 }
 
 template <typename T, typename... Args>
@@ -62,4 +209,88 @@ template <typename T> void destroy_at(T *p) {
   }
 }
 
+// 在iterator开始的n个未初始化位置上构造value的拷贝
+// 可以平凡复制的类型(包括用户自己的聚合体)按字节填充 否则逐个拷贝构造
+// 出异常时析构已经构造的元素
+template <typename Forward_iterator, typename value_type>
+void uninit(Forward_iterator iterator, std::size_t n, const value_type &value) {
+  if constexpr (std::is_same_v<Forward_iterator, value_type *> &&
+                std::is_trivially_copyable_v<value_type>) {
+    fill_trivial(iterator, n, value);
+  } else {
+    Forward_iterator cur = iterator;
+    try {
+      for (; n > 0; --n, ++cur)
+        ::construct_at(&*cur, value);
+    } catch (...) {
+      for (; iterator != cur; ++iterator)
+        ::destroy_at(&*iterator);
+      throw;
+    }
+  }
+}
+
+// 可以平凡析构的类型什么也不做
+template <typename Forward_iterator, typename value_type>
+void deconstruct(Forward_iterator iterator) {
+  if constexpr (!std::is_trivially_destructible_v<value_type>)
+    (*iterator).~value_type();
+}
+
+// 可以平凡搬迁的类型: 把对象的字节复制到新地址 并且不再析构旧对象 等价于
+// 移动构造加上析构旧对象 这样的类型扩容时整段memcpy
+// 默认只包括可以平凡复制的类型 其他类型需要自己特化成true
+// 例如只保存一个堆指针的句柄类 对象里有指向自己的指针时不能特化
+// (libstdc++的std::string就是这样)
+template <typename T>
+struct is_trivially_relocatable : std::is_trivially_copyable<T> {};
+
+// 标准库里只保存指针的智能指针 在各个实现里都可以直接搬迁
+template <typename T>
+struct is_trivially_relocatable<std::unique_ptr<T>> : std::true_type {};
+template <typename T>
+struct is_trivially_relocatable<std::shared_ptr<T>> : std::true_type {};
+
+template <typename T>
+inline constexpr bool is_trivially_relocatable_v =
+    is_trivially_relocatable<T>::value;
+
+// 把[first, last)的对象逐个std::move_if_noexcept构造到dest开始的未初始化内存
+// 返回新的末尾 移动构造可能抛异常时退回到拷贝 出异常时已经构造的新对象被析构
+// 旧对象保持不变
+template <typename T> T *uninit_move_if_noexcept(T *first, T *last, T *dest) {
+  T *cur = dest;
+  try {
+    for (; first != last; ++first, ++cur)
+      ::construct_at(cur, std::move_if_noexcept(*first));
+  } catch (...) {
+    for (; dest != cur; ++dest)
+      ::destroy_at(dest);
+    throw;
+  }
+  return cur;
+}
+
+// 把[first, last)的对象搬到从dest开始的未初始化内存 返回新的末尾
+// 可以平凡搬迁时整段按字节复制
+// 移动构造不会抛异常时每个对象移动之后马上析构 只遍历一遍
+// 否则用uninit_move_if_noexcept拷贝 全部成功之后才析构旧对象 失败时旧对象不变
+template <typename T> T *uninit_relocate(T *first, T *last, T *dest) {
+  if constexpr (is_trivially_relocatable_v<T>) {
+    move_trivial(dest, first, last - first);
+    return dest + (last - first);
+  } else if constexpr (std::is_nothrow_move_constructible_v<T>) {
+    for (; first != last; ++first, ++dest) {
+      ::construct_at(dest, std::move(*first));
+      ::destroy_at(first);
+    }
+    return dest;
+  } else {
+    T *result = uninit_move_if_noexcept(first, last, dest);
+    for (; first != last; ++first)
+      ::destroy_at(first);
+    return result;
+  }
+}
+
 #endif // _UNINITIAL_H_
\ No newline at end of file
@@ -38,5 +38,22 @@ int main() {
   is_pod_type.push_back(1);
   std::cout<< is_pod_type[0]<<std::endl;
 
+  std::cout << "--------------------------------" << std::endl;
+  // 预留容量后批量插入 区间插入只申请一次内存
+  m_vector<int> bulk;
+  bulk.reserve(100);
+  std::cout << "reserve: " << bulk.capacity() << std::endl;
+  bulk.insert(bulk.end(), vec.begin(), vec.end());
+  bulk.insert(bulk.begin(), {5, 6, 7});
+  bulk.erase(bulk.begin() + 1, bulk.begin() + 3);
+  bulk.resize(20, 9);
+  bulk.pop_back();
+  for (int v : bulk)
+    std::cout << v;
+  std::cout << std::endl;
+  bulk.shrink_to_fit();
+  std::cout << "size: " << bulk.size() << " capacity: " << bulk.capacity()
+            << std::endl;
+
   return 0;
 }
\ No newline at end of file
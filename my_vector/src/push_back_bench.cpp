@@ -0,0 +1,139 @@
+#include "../include/my_vector.h"
+#include <chrono>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+
+// push_back为主的测试 比较m_vector扩容时三种搬迁方式的耗时
+//   copy: 移动构造可能抛异常 std::move_if_noexcept退回到拷贝 和原来的扩容一样
+//   move: 移动构造是noexcept的 逐个移动
+//   memcpy: 可以平凡复制或者特化了is_trivially_relocatable 整段复制
+// 每组同样的数据再用std::vector跑一遍作为参照
+// 最后把一个long的数组增长到元素个数的100倍 比较耗时和峰值RSS
+// 超过256KB的缓冲区直接mmap m_vector扩容时用mremap 不需要同时持有新旧两块
+// 用法: ./push_back_bench [元素个数] [轮数]
+
+// 移动构造没有标noexcept的字符串 扩容时只能拷贝
+struct copy_string {
+  std::string s;
+  copy_string(const std::string &str) : s(str) {}
+  copy_string(const copy_string &other) : s(other.s) {}
+  copy_string(copy_string &&other) : s(std::move(other.s)) {}
+};
+
+// 自定义了拷贝构造的小结构体 不能平凡复制 只能逐个拷贝
+struct point_copy {
+  double x, y, z;
+  point_copy(double v) : x(v), y(v), z(v) {}
+  point_copy(const point_copy &other) : x(other.x), y(other.y), z(other.z) {}
+};
+
+// 可以平凡复制的小结构体 扩容时直接memcpy
+struct point {
+  double x, y, z;
+  point(double v) : x(v), y(v), z(v) {}
+};
+
+// 持有一块堆内存的句柄 移动构造是noexcept的
+struct handle {
+  int *p;
+  handle(int v) : p(new int(v)) {}
+  handle(const handle &other) : p(new int(*other.p)) {}
+  handle(handle &&other) noexcept : p(other.p) { other.p = nullptr; }
+  ~handle() { delete p; }
+};
+
+// 和handle一样 但是声明成可以平凡搬迁
+struct relocatable_handle : handle {
+  using handle::handle;
+};
+template <>
+struct is_trivially_relocatable<relocatable_handle> : std::true_type {};
+
+static long sink = 0;
+
+// 进程的峰值RSS 单位MB 写clear_refs可以把峰值重置成当前值 只在linux下有
+static double peak_rss_mb(bool reset) {
+  if (reset) {
+    std::ofstream out("/proc/self/clear_refs");
+    out << "5";
+    return 0;
+  }
+  std::ifstream in("/proc/self/status");
+  std::string line;
+  while (std::getline(in, line))
+    if (line.compare(0, 6, "VmHWM:") == 0)
+      return std::strtod(line.c_str() + 6, nullptr) / 1024;
+  return 0;
+}
+
+// 一次性增长到count个元素 输出耗时和这期间的峰值RSS
+template <typename Vector> static void run_large(const char *name, size_t count) {
+  peak_rss_mb(true);
+  auto begin = std::chrono::steady_clock::now();
+  {
+    Vector v;
+    for (size_t i = 0; i < count; i++)
+      v.push_back(long(i));
+    sink += v.size();
+  }
+  auto end = std::chrono::steady_clock::now();
+  double ms = std::chrono::duration<double, std::milli>(end - begin).count();
+  std::cout << name << "\t" << ms << " ms\t" << peak_rss_mb(false)
+            << " MB peak" << std::endl;
+}
+
+template <typename Vector, typename Make>
+static void run(const char *name, size_t count, int rounds, Make make) {
+  auto begin = std::chrono::steady_clock::now();
+  for (int r = 0; r < rounds; r++) {
+    Vector v;
+    for (size_t i = 0; i < count; i++)
+      v.push_back(make(i));
+    sink += v.size();
+  }
+  auto end = std::chrono::steady_clock::now();
+  double ms = std::chrono::duration<double, std::milli>(end - begin).count();
+  std::cout << name << "\t" << ms << " ms\t" << ms * 1e6 / (count * rounds)
+            << " ns/op" << std::endl;
+}
+
+int main(int argc, char *argv[]) {
+  size_t count = 200000;
+  int rounds = 10;
+  if (argc > 1)
+    count = std::strtoul(argv[1], nullptr, 10);
+  if (argc > 2)
+    rounds = std::atoi(argv[2]);
+
+  // 超过短字符串优化的长度 每个字符串都有自己的堆内存
+  const std::string text(32, 's');
+  auto make_string = [&](size_t) { return text; };
+  auto make_double = [](size_t i) { return double(i); };
+  auto make_int = [](size_t i) { return int(i); };
+
+  std::cout << "-- string" << std::endl;
+  run<m_vector<copy_string>>("copy", count, rounds, make_string);
+  run<m_vector<std::string>>("move", count, rounds, make_string);
+  run<std::vector<std::string>>("std::vector", count, rounds, make_string);
+
+  std::cout << "-- small struct (24 bytes)" << std::endl;
+  run<m_vector<point_copy>>("copy", count, rounds, make_double);
+  run<m_vector<point>>("memcpy", count, rounds, make_double);
+  run<std::vector<point>>("std::vector", count, rounds, make_double);
+
+  std::cout << "-- handle" << std::endl;
+  run<m_vector<handle>>("move", count, rounds, make_int);
+  run<m_vector<relocatable_handle>>("memcpy", count, rounds, make_int);
+  run<std::vector<handle>>("std::vector", count, rounds, make_int);
+
+  std::cout << "-- large long array (" << count * 100 * sizeof(long) / 1000000
+            << " MB)" << std::endl;
+  run_large<m_vector<long>>("m_vector", count * 100);
+  run_large<std::vector<long>>("std::vector", count * 100);
+
+  std::cout << "checksum: " << sink << std::endl;
+  return 0;
+}
@@ -0,0 +1,95 @@
+#include "../include/my_vector.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <memory>
+#include <vector>
+
+// uninitial.h里填充内核的测试 元素大小从1到64字节
+// 在未初始化内存上填充同一个元素 对应allocate_and_fill和insert(pos, n, value)
+// loop是逐个元素复制的循环 sse2/avx2直接调用对应的内核 dispatch是运行时选择的结果
+// 输出每种方式的吞吐 单位GB/s
+// 用法: ./simd_bench [缓冲区字节数] [总字节数(MB)]
+
+template <size_t N> struct elem {
+  unsigned char b[N];
+};
+
+static volatile unsigned char sink = 0;
+
+template <typename F>
+static double gbps(size_t bytes, size_t total, F &&f) {
+  size_t rounds = total / bytes + 1;
+  auto begin = std::chrono::steady_clock::now();
+  for (size_t r = 0; r < rounds; r++)
+    f(r);
+  auto end = std::chrono::steady_clock::now();
+  double s = std::chrono::duration<double>(end - begin).count();
+  return double(bytes) * rounds / s / 1e9;
+}
+
+template <size_t N> static void run(size_t bytes, size_t total) {
+  using T = elem<N>;
+  size_t n = bytes / N;
+  std::unique_ptr<T[]> buf(new T[n]);
+  T value;
+  for (size_t i = 0; i < N; i++)
+    value.b[i] = (unsigned char)(i + 1);
+
+  std::cout << N << "\t";
+  std::cout << gbps(bytes, total, [&](size_t r) {
+    value.b[0] = (unsigned char)r;
+    T tmp = value;
+    for (size_t i = 0; i < n; i++)
+      std::memcpy(&buf[i], &tmp, N);
+    sink = buf[n / 2].b[0];
+  }) << "\t";
+#if SIMD_ON
+  std::cout << gbps(bytes, total, [&](size_t r) {
+    value.b[0] = (unsigned char)r;
+    if (!simd_kernel::fill_sse2(buf.get(), &value, N, n))
+      std::abort();
+    sink = buf[n / 2].b[0];
+  }) << "\t";
+  if (__builtin_cpu_supports("avx2"))
+    std::cout << gbps(bytes, total, [&](size_t r) {
+      value.b[0] = (unsigned char)r;
+      if (!simd_kernel::fill_avx2(buf.get(), &value, N, n))
+        std::abort();
+      sink = buf[n / 2].b[0];
+    }) << "\t";
+  else
+    std::cout << "-\t";
+#endif // SIMD_ON
+  std::cout << gbps(bytes, total, [&](size_t r) {
+    value.b[0] = (unsigned char)r;
+    fill_trivial(buf.get(), n, value);
+    sink = buf[n / 2].b[0];
+  }) << std::endl;
+}
+
+int main(int argc, char *argv[]) {
+  size_t bytes = 4096;
+  size_t total = 2000;
+  if (argc > 1)
+    bytes = std::strtoul(argv[1], nullptr, 10);
+  if (argc > 2)
+    total = std::strtoul(argv[2], nullptr, 10);
+  total *= 1000000;
+
+  std::cout << "buffer " << bytes << " bytes, GB/s" << std::endl;
+  std::cout << "size\tloop\tsse2\tavx2\tdispatch" << std::endl;
+  run<1>(bytes, total);
+  run<2>(bytes, total);
+  run<3>(bytes, total);
+  run<4>(bytes, total);
+  run<8>(bytes, total);
+  run<12>(bytes, total);
+  run<16>(bytes, total);
+  run<24>(bytes, total);
+  run<32>(bytes, total);
+  run<48>(bytes, total);
+  run<64>(bytes, total);
+  return 0;
+}